@@ -1,4 +1,126 @@
 #include "aht20.h"
+#include "sleep_ms.h"
+
+/* Convert measurement frame into degrees Celsius and %RH */
+static void AHT20_ConvertData(const uint8_t *data, float *temperature,
+                              float *humidity) {
+  uint32_t humidity_raw, temperature_raw;
+
+  // Extract 20-bit humidity value from bytes 1, 2, and 3
+  // Byte 1: humidity MSB
+  // Byte 2: humidity middle byte
+  // Byte 3: bits[7:4] are humidity LSB
+  humidity_raw = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) |
+                 ((uint32_t)data[3] >> 4);
+
+  // Extract 20-bit temperature value from bytes 3, 4, and 5
+  // Byte 3: bits[3:0] are temperature MSB
+  // Byte 4: temperature middle byte
+  // Byte 5: temperature LSB
+  temperature_raw = ((uint32_t)(data[3] & 0x0F) << 16) |
+                    ((uint32_t)data[4] << 8) | ((uint32_t)data[5]);
+
+  // Convert to %RH using formula from datasheet: RH = (S_RH / 2^20) * 100%
+  *humidity = ((float)humidity_raw / 1048576.0f) * 100.0f;
+
+  // Convert to Celsius using formula from datasheet: T = (S_T / 2^20) * 200 -
+  // 50
+  *temperature = ((float)temperature_raw / 1048576.0f) * 200.0f - 50.0f;
+}
+
+/**
+ * @brief Decode a measurement frame into fixed-point values
+ * @param data Measurement frame (at least AHT20_FRAME_SIZE bytes), e.g. logged
+ * raw data or haht20->frame
+ * @param temperature Pointer to store temperature in 0.01 degC (2345 = 23.45)
+ * @param humidity Pointer to store humidity in 0.01 %RH (4567 = 45.67)
+ * @note The datasheet divisor is 2^20, so both conversions reduce to an integer
+ * multiply and shift: 20000 / 2^20 = 625 / 2^15 and 10000 / 2^20 = 625 / 2^16
+ */
+void AHT20_DecodeFrame(const uint8_t *data, int32_t *temperature,
+                       int32_t *humidity) {
+  uint32_t humidity_raw, temperature_raw;
+
+  humidity_raw = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) |
+                 ((uint32_t)data[3] >> 4);
+  temperature_raw = ((uint32_t)(data[3] & 0x0F) << 16) |
+                    ((uint32_t)data[4] << 8) | ((uint32_t)data[5]);
+
+  // RH = S_RH * 10000 / 2^20 [0.01 %RH], rounded
+  *humidity = (int32_t)((humidity_raw * 625 + (1U << 15)) >> 16);
+
+  // T = S_T * 20000 / 2^20 - 5000 [0.01 degC], rounded
+  *temperature = (int32_t)((temperature_raw * 625 + (1U << 14)) >> 15) - 5000;
+}
+
+/* CRC-8 lookup table, polynomial 0x31 (x^8 + x^5 + x^4 + 1) */
+static const uint8_t aht20_crc8_table[256] = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+    0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+    0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+    0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+    0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+    0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+    0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+    0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+    0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+    0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+    0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+    0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+    0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+    0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+    0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+    0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+    0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+    0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+    0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+    0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+    0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+    0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+    0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+    0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+    0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+    0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+    0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+    0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+    0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+    0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+    0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+};
+
+/**
+ * @brief Calculate AHT20 CRC-8 (polynomial 0x31, init 0xFF)
+ * @param data Buffer to calculate the checksum of
+ * @param size Number of bytes
+ * @return CRC-8 of the buffer
+ */
+uint8_t AHT20_Crc8(const uint8_t *data, uint8_t size) {
+  uint8_t crc = AHT20_CRC_INIT;
+
+  for (uint8_t i = 0; i < size; i++) {
+    crc = aht20_crc8_table[crc ^ data[i]];
+  }
+
+  return crc;
+}
+
+/* Store a freshly read measurement frame in the handle cache */
+static void AHT20_CacheFrame(AHT20_HandleTypeDef *haht20,
+                             const uint8_t *data) {
+  for (uint8_t i = 0; i < AHT20_FRAME_SIZE; i++) {
+    haht20->frame[i] = data[i];
+  }
+
+  haht20->frame_tick = HAL_GetTick();
+  haht20->frame_valid = 1;
+}
+
+/* Check if the cached frame is younger than cache_max_age */
+static uint8_t AHT20_IsCacheFresh(AHT20_HandleTypeDef *haht20) {
+  return haht20->frame_valid &&
+         (HAL_GetTick() - haht20->frame_tick < haht20->cache_max_age);
+}
 
 HAL_StatusTypeDef AHT20_ReadStatus(AHT20_HandleTypeDef *haht20) {
   HAL_StatusTypeDef hal_status;
@@ -28,7 +150,7 @@ HAL_StatusTypeDef AHT20_SoftReset(AHT20_HandleTypeDef *haht20) {
     return hal_status;
   }
 
-  HAL_Delay(AHT20_SOFT_RESET_DELAY);
+  sleep_ms(AHT20_SOFT_RESET_DELAY);
 
   return HAL_OK;
 }
@@ -59,7 +181,7 @@ HAL_StatusTypeDef AHT20_WaitUntilReady(AHT20_HandleTypeDef *haht20,
       return HAL_OK;
     }
 
-    HAL_Delay(delay_ms);
+    sleep_ms(delay_ms);
     retry_count++;
   }
 
@@ -80,8 +202,13 @@ HAL_StatusTypeDef AHT20_Init(AHT20_HandleTypeDef *haht20,
 
   haht20->hi2c = hi2c;
   haht20->address = address;
+  haht20->measuring = 0;
+  haht20->frame_valid = 0;
+  haht20->cache_max_age = AHT20_CACHE_MAX_AGE;
+  haht20->use_crc = 0;
+  haht20->error = AHT20_ERROR_NONE;
 
-  HAL_Delay(AHT20_POWER_ON_DELAY);
+  sleep_ms(AHT20_POWER_ON_DELAY);
 
   hal_status = AHT20_ReadStatus(haht20);
   if (hal_status != HAL_OK) {
@@ -100,7 +227,7 @@ HAL_StatusTypeDef AHT20_Init(AHT20_HandleTypeDef *haht20,
       return hal_status;
     }
 
-    HAL_Delay(AHT20_INIT_DELAY);
+    sleep_ms(AHT20_INIT_DELAY);
 
     hal_status = AHT20_ReadStatus(haht20);
     if (hal_status != HAL_OK) {
@@ -147,44 +274,130 @@ HAL_StatusTypeDef AHT20_ReadData(AHT20_HandleTypeDef *haht20, uint8_t *data,
 }
 
 /**
- * @brief Read temperature from AHT20 sensor
- * @param haht20 Pointer to AHT20 handle structure
- * @param temperature Pointer to store temperature value in degrees Celsius
- * @return HAL status
+ * Read measurement frame and take the status from its first byte, which
+ * carries the same busy and calibrated bits as the status register. Returns
+ * HAL_BUSY while the measurement is in progress. The trailing CRC byte is
+ * verified in CRC mode
  */
-HAL_StatusTypeDef AHT20_ReadTemperature(AHT20_HandleTypeDef *haht20,
-                                        float *temperature) {
+static HAL_StatusTypeDef AHT20_ReadFrame(AHT20_HandleTypeDef *haht20,
+                                         uint8_t *data) {
   HAL_StatusTypeDef hal_status;
-  uint8_t data[6];
-  uint32_t temperature_raw;
 
-  hal_status = AHT20_TriggerMeasurement(haht20);
+  hal_status = AHT20_ReadData(haht20, data,
+                              haht20->use_crc ? AHT20_FRAME_SIZE_CRC
+                                              : AHT20_FRAME_SIZE);
   if (hal_status != HAL_OK) {
     return hal_status;
   }
 
-  HAL_Delay(AHT20_MEASURE_DELAY);
+  haht20->status = data[0];
 
-  hal_status = AHT20_WaitUntilReady(haht20, 5, 5);
+  if (AHT20_IsBusy(haht20)) {
+    return HAL_BUSY;
+  }
+
+  if (haht20->use_crc &&
+      AHT20_Crc8(data, AHT20_FRAME_SIZE) != data[AHT20_FRAME_SIZE]) {
+    haht20->error = AHT20_ERROR_CRC;
+    return HAL_ERROR;
+  }
+
+  return HAL_OK;
+}
+
+/* Trigger a measurement, wait for it and store the frame in the cache */
+static HAL_StatusTypeDef AHT20_Measure(AHT20_HandleTypeDef *haht20) {
+  HAL_StatusTypeDef hal_status;
+  uint8_t data[AHT20_FRAME_SIZE_CRC];
+  uint8_t retry_count = 0;
+
+  haht20->error = AHT20_ERROR_NONE;
+  // A failed read must not leave an older frame to be served as fresh
+  haht20->frame_valid = 0;
+
+  hal_status = AHT20_TriggerMeasurement(haht20);
   if (hal_status != HAL_OK) {
     return hal_status;
   }
 
-  hal_status = AHT20_ReadData(haht20, data, 6);
+  sleep_ms(AHT20_MEASURE_DELAY);
+
+  // Poll the frame itself instead of the status register, a ready sensor
+  // answers with the complete measurement in the same transaction
+  while (retry_count < AHT20_POLL_RETRIES) {
+    hal_status = AHT20_ReadFrame(haht20, data);
+
+    if (hal_status != HAL_BUSY) {
+      break;
+    }
+
+    sleep_ms(AHT20_POLL_DELAY);
+    retry_count++;
+  }
+
+  if (hal_status == HAL_BUSY) {
+    return HAL_TIMEOUT;
+  }
+
   if (hal_status != HAL_OK) {
     return hal_status;
   }
 
-  // Extract 20-bit temperature value from bytes 3, 4, and 5
-  // Byte 3: bits[3:0] are temperature MSB
-  // Byte 4: temperature middle byte
-  // Byte 5: temperature LSB
-  temperature_raw = ((uint32_t)(data[3] & 0x0F) << 16) |
-                    ((uint32_t)data[4] << 8) | ((uint32_t)data[5]);
+  AHT20_CacheFrame(haht20, data);
 
-  // Convert to Celsius using formula from datasheet: T = (S_T / 2^20) * 200 -
-  // 50
-  *temperature = ((float)temperature_raw / 1048576.0f) * 200.0f - 50.0f;
+  return HAL_OK;
+}
+
+/**
+ * @brief Enable or disable CRC verified reads
+ * @param haht20 Pointer to AHT20 handle structure
+ * @param enable 1 to read and verify the CRC byte of every frame, 0 to skip it
+ * @note On CRC mismatch reads return HAL_ERROR and AHT20_GetError returns
+ * AHT20_ERROR_CRC, so the caller can retry only corrupted frames
+ */
+void AHT20_EnableCrc(AHT20_HandleTypeDef *haht20, uint8_t enable) {
+  haht20->use_crc = enable ? 1 : 0;
+}
+
+/**
+ * @brief Get error code of the last measurement read
+ * @param haht20 Pointer to AHT20 handle structure
+ * @return AHT20_ERROR_NONE or AHT20_ERROR_CRC
+ */
+uint32_t AHT20_GetError(AHT20_HandleTypeDef *haht20) { return haht20->error; }
+
+/**
+ * @brief Set maximum age of the cached measurement
+ * @param haht20 Pointer to AHT20 handle structure
+ * @param max_age_ms Maximum age in milliseconds, 0 disables the cache
+ * @note ReadTemperature and ReadHumidity serve values from the last frame while
+ * it is younger than max_age_ms, so reading both triggers one measurement. A
+ * failed read, including a CRC mismatch or timeout, drops the cached frame
+ */
+void AHT20_SetCacheMaxAge(AHT20_HandleTypeDef *haht20, uint32_t max_age_ms) {
+  haht20->cache_max_age = max_age_ms;
+}
+
+/**
+ * @brief Read temperature from AHT20 sensor
+ * @param haht20 Pointer to AHT20 handle structure
+ * @param temperature Pointer to store temperature value in degrees Celsius
+ * @return HAL status
+ * @note Served from the cached frame when it is fresh
+ */
+HAL_StatusTypeDef AHT20_ReadTemperature(AHT20_HandleTypeDef *haht20,
+                                        float *temperature) {
+  HAL_StatusTypeDef hal_status;
+  float humidity;
+
+  if (!AHT20_IsCacheFresh(haht20)) {
+    hal_status = AHT20_Measure(haht20);
+    if (hal_status != HAL_OK) {
+      return hal_status;
+    }
+  }
+
+  AHT20_ConvertData(haht20->frame, temperature, &humidity);
 
   return HAL_OK;
 }
@@ -194,39 +407,21 @@ HAL_StatusTypeDef AHT20_ReadTemperature(AHT20_HandleTypeDef *haht20,
  * @param haht20 Pointer to AHT20 handle structure
  * @param humidity Pointer to store humidity value in %RH
  * @return HAL status
+ * @note Served from the cached frame when it is fresh
  */
 HAL_StatusTypeDef AHT20_ReadHumidity(AHT20_HandleTypeDef *haht20,
                                      float *humidity) {
   HAL_StatusTypeDef hal_status;
-  uint8_t data[6];
-  uint32_t humidity_raw;
-
-  hal_status = AHT20_TriggerMeasurement(haht20);
-  if (hal_status != HAL_OK) {
-    return hal_status;
-  }
+  float temperature;
 
-  HAL_Delay(AHT20_MEASURE_DELAY);
-
-  hal_status = AHT20_WaitUntilReady(haht20, 5, 5);
-  if (hal_status != HAL_OK) {
-    return hal_status;
+  if (!AHT20_IsCacheFresh(haht20)) {
+    hal_status = AHT20_Measure(haht20);
+    if (hal_status != HAL_OK) {
+      return hal_status;
+    }
   }
 
-  hal_status = AHT20_ReadData(haht20, data, 6);
-  if (hal_status != HAL_OK) {
-    return hal_status;
-  }
-
-  // Extract 20-bit humidity value from bytes 1, 2, and 3
-  // Byte 1: humidity MSB
-  // Byte 2: humidity middle byte
-  // Byte 3: bits[7:4] are humidity LSB
-  humidity_raw = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) |
-                 ((uint32_t)data[3] >> 4);
-
-  // Convert to %RH using formula from datasheet: RH = (S_RH / 2^20) * 100%
-  *humidity = ((float)humidity_raw / 1048576.0f) * 100.0f;
+  AHT20_ConvertData(haht20->frame, &temperature, humidity);
 
   return HAL_OK;
 }
@@ -238,42 +433,116 @@ HAL_StatusTypeDef AHT20_ReadHumidity(AHT20_HandleTypeDef *haht20,
  * @param humidity Pointer to store humidity value in %RH
  * @return HAL status
  * @note This function is more efficient than calling ReadTemperature and
- * ReadHumidity separately as it only triggers one measurement for both values
+ * ReadHumidity separately as it only triggers one measurement for both values.
+ * It always triggers a new measurement and refreshes the cache
  */
 HAL_StatusTypeDef AHT20_ReadAll(AHT20_HandleTypeDef *haht20, float *temperature,
                                 float *humidity) {
   HAL_StatusTypeDef hal_status;
-  uint8_t data[6];
-  uint32_t humidity_raw, temperature_raw;
 
-  hal_status = AHT20_TriggerMeasurement(haht20);
+  hal_status = AHT20_Measure(haht20);
   if (hal_status != HAL_OK) {
     return hal_status;
   }
 
-  HAL_Delay(AHT20_MEASURE_DELAY);
+  AHT20_ConvertData(haht20->frame, temperature, humidity);
+
+  return HAL_OK;
+}
 
-  hal_status = AHT20_WaitUntilReady(haht20, 5, 5);
+/**
+ * @brief Start a measurement without waiting for it
+ * @param haht20 Pointer to AHT20 handle structure
+ * @return HAL status
+ * @note Records the trigger tick, use AHT20_TryCollect to fetch the result
+ */
+HAL_StatusTypeDef AHT20_StartMeasurement(AHT20_HandleTypeDef *haht20) {
+  HAL_StatusTypeDef hal_status;
+
+  hal_status = AHT20_TriggerMeasurement(haht20);
   if (hal_status != HAL_OK) {
     return hal_status;
   }
 
-  hal_status = AHT20_ReadData(haht20, data, 6);
+  haht20->trigger_tick = HAL_GetTick();
+  haht20->measuring = 1;
+
+  return HAL_OK;
+}
+
+/**
+ * @brief Collect a measurement started with AHT20_StartMeasurement
+ * @param haht20 Pointer to AHT20 handle structure
+ * @param temperature Pointer to store temperature value in degrees Celsius
+ * @param humidity Pointer to store humidity value in %RH
+ * @return HAL_BUSY until AHT20_MEASURE_DELAY has passed and the sensor reports
+ * ready, HAL_OK when values were stored, HAL_TIMEOUT if the sensor is still
+ * busy AHT20_COLLECT_TIMEOUT ms after the trigger, HAL_ERROR if no measurement
+ * was started, or other HAL error code if a transaction fails
+ * @note Never blocks, call it periodically from the main loop. A timeout ends
+ * the measurement like any other result, start a new one to retry. temperature
+ * and humidity may be NULL to only refresh haht20->frame, e.g. for
+ * AHT20_DecodeFrame
+ */
+HAL_StatusTypeDef AHT20_TryCollect(AHT20_HandleTypeDef *haht20,
+                                   float *temperature, float *humidity) {
+  HAL_StatusTypeDef hal_status;
+  uint8_t data[AHT20_FRAME_SIZE_CRC];
+
+  if (!haht20->measuring) {
+    return HAL_ERROR;
+  }
+
+  if (HAL_GetTick() - haht20->trigger_tick < AHT20_MEASURE_DELAY) {
+    return HAL_BUSY;
+  }
+
+  haht20->error = AHT20_ERROR_NONE;
+
+  hal_status = AHT20_ReadFrame(haht20, data);
+  if (hal_status == HAL_BUSY) {
+    // Same bound as the poll limit of the blocking read
+    if (HAL_GetTick() - haht20->trigger_tick < AHT20_COLLECT_TIMEOUT) {
+      return HAL_BUSY;
+    }
+
+    hal_status = HAL_TIMEOUT;
+  }
+
+  haht20->measuring = 0;
+
   if (hal_status != HAL_OK) {
+    haht20->frame_valid = 0;
     return hal_status;
   }
 
-  // Extract 20-bit humidity value from bytes 1, 2, and 3
-  humidity_raw = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) |
-                 ((uint32_t)data[3] >> 4);
+  AHT20_CacheFrame(haht20, data);
 
-  // Extract 20-bit temperature value from bytes 3, 4, and 5
-  temperature_raw = ((uint32_t)(data[3] & 0x0F) << 16) |
-                    ((uint32_t)data[4] << 8) | ((uint32_t)data[5]);
+  if (temperature != NULL && humidity != NULL) {
+    AHT20_ConvertData(data, temperature, humidity);
+  }
 
-  // Convert to Celsius and %RH
-  *humidity = ((float)humidity_raw / 1048576.0f) * 100.0f;
-  *temperature = ((float)temperature_raw / 1048576.0f) * 200.0f - 50.0f;
+  return HAL_OK;
+}
+
+/**
+ * @brief Read both temperature and humidity as fixed-point values
+ * @param haht20 Pointer to AHT20 handle structure
+ * @param temperature Pointer to store temperature in 0.01 degC
+ * @param humidity Pointer to store humidity in 0.01 %RH
+ * @return HAL status
+ * @note Integer-only counterpart of AHT20_ReadAll, needs no FPU or float printf
+ */
+HAL_StatusTypeDef AHT20_ReadAllFixed(AHT20_HandleTypeDef *haht20,
+                                     int32_t *temperature, int32_t *humidity) {
+  HAL_StatusTypeDef hal_status;
+
+  hal_status = AHT20_Measure(haht20);
+  if (hal_status != HAL_OK) {
+    return hal_status;
+  }
+
+  AHT20_DecodeFrame(haht20->frame, temperature, humidity);
 
   return HAL_OK;
 }
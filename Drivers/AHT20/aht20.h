@@ -31,12 +31,41 @@
 #define AHT20_INIT_DELAY 10
 #define AHT20_MEASURE_DELAY 80
 #define AHT20_SOFT_RESET_DELAY 20
+#define AHT20_POLL_DELAY 5   // Between frame polls of a busy sensor
+#define AHT20_POLL_RETRIES 5 // Frame polls after AHT20_MEASURE_DELAY
+#define AHT20_COLLECT_TIMEOUT                                                  \
+  (AHT20_MEASURE_DELAY + AHT20_POLL_RETRIES * AHT20_POLL_DELAY)
+#define AHT20_CACHE_MAX_AGE 1000 // Default, see AHT20_SetCacheMaxAge
+
+/* AHT20 Measurement Frame Size (status, humidity, temperature) */
+#define AHT20_FRAME_SIZE 6
+#define AHT20_FRAME_SIZE_CRC 7
+
+/* AHT20 CRC-8 (polynomial x^8 + x^5 + x^4 + 1) */
+#define AHT20_CRC_INIT 0xFF
+
+/* AHT20 Error Codes */
+#define AHT20_ERROR_NONE 0x00
+#define AHT20_ERROR_CRC 0x01
 
 /* AHT20 Handle Structure */
 typedef struct {
   I2C_HandleTypeDef *hi2c;
   uint16_t address;
   uint8_t status;
+
+  /* Non-blocking measurement */
+  uint32_t trigger_tick;
+  uint8_t measuring;
+
+  /* Last measurement frame cache */
+  uint8_t frame[AHT20_FRAME_SIZE];
+  uint32_t frame_tick;
+  uint8_t frame_valid;
+  uint32_t cache_max_age; // [ms], 0 disables the cache
+
+  uint8_t use_crc;
+  uint32_t error;
 } AHT20_HandleTypeDef;
 
 /* Function Prototypes */
@@ -49,6 +78,12 @@ HAL_StatusTypeDef AHT20_SoftReset(AHT20_HandleTypeDef *haht20);
 HAL_StatusTypeDef AHT20_TriggerMeasurement(AHT20_HandleTypeDef *haht20);
 HAL_StatusTypeDef AHT20_ReadData(AHT20_HandleTypeDef *haht20, uint8_t *data,
                                  uint8_t size);
+void AHT20_DecodeFrame(const uint8_t *data, int32_t *temperature,
+                       int32_t *humidity);
+uint8_t AHT20_Crc8(const uint8_t *data, uint8_t size);
+void AHT20_EnableCrc(AHT20_HandleTypeDef *haht20, uint8_t enable);
+uint32_t AHT20_GetError(AHT20_HandleTypeDef *haht20);
+void AHT20_SetCacheMaxAge(AHT20_HandleTypeDef *haht20, uint32_t max_age_ms);
 HAL_StatusTypeDef AHT20_ReadTemperature(AHT20_HandleTypeDef *haht20,
                                         float *temperature);
 HAL_StatusTypeDef AHT20_ReadHumidity(AHT20_HandleTypeDef *haht20,
@@ -57,5 +92,10 @@ HAL_StatusTypeDef AHT20_ReadAll(AHT20_HandleTypeDef *haht20, float *temperature,
                                 float *humidity);
 HAL_StatusTypeDef AHT20_WaitUntilReady(AHT20_HandleTypeDef *haht20,
                                        uint8_t max_retries, uint16_t delay_ms);
+HAL_StatusTypeDef AHT20_StartMeasurement(AHT20_HandleTypeDef *haht20);
+HAL_StatusTypeDef AHT20_TryCollect(AHT20_HandleTypeDef *haht20,
+                                   float *temperature, float *humidity);
+HAL_StatusTypeDef AHT20_ReadAllFixed(AHT20_HandleTypeDef *haht20,
+                                     int32_t *temperature, int32_t *humidity);
 
 #endif
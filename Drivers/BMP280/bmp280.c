@@ -1,4 +1,7 @@
 #include "bmp280.h"
+#include "main.h"
+#include "sleep_ms.h"
+#include <string.h>
 
 static HAL_StatusTypeDef BMP280_ReadCalibration(BMP280_HandleTypeDef *hbmp280) {
   uint8_t calibration_data[BMP280_TRIMM_PARAM_REGISTERS_COUNT];
@@ -36,6 +39,9 @@ HAL_StatusTypeDef BMP280_Init(BMP280_HandleTypeDef *hbmp280,
 
   hbmp280->hi2c = hi2c;
   hbmp280->address = address;
+  hbmp280->read_pending = 0;
+  hbmp280->temp_oversamp = BMP280_OVERSAMPLING_SKIP;
+  hbmp280->press_oversamp = BMP280_OVERSAMPLING_SKIP;
 
   status = HAL_I2C_Mem_Read(hbmp280->hi2c, hbmp280->address, BMP280_REG_CHIP_ID,
                             I2C_MEMADD_SIZE_8BIT, &chip_id, 1, 1000);
@@ -47,6 +53,8 @@ HAL_StatusTypeDef BMP280_Init(BMP280_HandleTypeDef *hbmp280,
     return HAL_ERROR;
   }
 
+  hbmp280->chip_id = chip_id;
+
   status = BMP280_ReadCalibration(hbmp280);
   if (status != HAL_OK) {
     return status;
@@ -74,15 +82,151 @@ HAL_StatusTypeDef BMP280_Configure(BMP280_HandleTypeDef *hbmp280,
   status =
       HAL_I2C_Mem_Write(hbmp280->hi2c, hbmp280->address, BMP280_REG_CTRL_MEAS,
                         I2C_MEMADD_SIZE_8BIT, &ctrl_meas_reg_value, 1, 1000);
+  if (status != HAL_OK) {
+    return status;
+  }
 
-  return status;
+  hbmp280->temp_oversamp = temp_oversamp;
+  hbmp280->press_oversamp = press_oversamp;
+
+  return HAL_OK;
+}
+
+/* Compensation formula from BMP280 datasheet, returns t_fine (fine
+ * resolution temperature used by pressure compensation) */
+static int32_t BMP280_CalculateTFine(const BMP280_HandleTypeDef *hbmp280,
+                                     int32_t adc_T) {
+  int32_t var1, var2;
+
+  var1 = ((((adc_T >> 3) - ((int32_t)hbmp280->dig_T1 << 1))) *
+          ((int32_t)hbmp280->dig_T2)) >>
+         11;
+  var2 = (((((adc_T >> 4) - ((int32_t)hbmp280->dig_T1)) *
+            ((adc_T >> 4) - ((int32_t)hbmp280->dig_T1))) >>
+           12) *
+          ((int32_t)hbmp280->dig_T3)) >>
+         14;
+
+  return var1 + var2;
+}
+
+/* Convert t_fine into temperature in 0.01 degC */
+static inline int32_t BMP280_TFineToTemperature(int32_t t_fine) {
+  return (t_fine * 5 + 128) >> 8;
+}
+
+/* Returns temperature in 0.01 degC and updates t_fine for the following
+ * pressure compensation */
+static int32_t BMP280_CompensateTemperature(BMP280_HandleTypeDef *hbmp280,
+                                            int32_t adc_T) {
+  hbmp280->t_fine = BMP280_CalculateTFine(hbmp280, adc_T);
+
+  return BMP280_TFineToTemperature(hbmp280->t_fine);
+}
+
+#if BMP280_USE_32BIT_COMPENSATION
+/* 32-bit compensation formula from BMP280 datasheet, returns pressure in Pa as
+ * unsigned Q24.8 (fractional part always 0) or 0 if the calibration data would
+ * cause division by zero */
+static uint32_t
+BMP280_CompensatePressure(const BMP280_HandleTypeDef *hbmp280, int32_t t_fine,
+                          int32_t adc_P) {
+  int32_t var1, var2;
+  uint32_t p;
+
+  var1 = (t_fine >> 1) - 64000;
+  var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)hbmp280->dig_P6);
+  var2 = var2 + ((var1 * ((int32_t)hbmp280->dig_P5)) << 1);
+  var2 = (var2 >> 2) + (((int32_t)hbmp280->dig_P4) << 16);
+  var1 = (((((int32_t)hbmp280->dig_P3) *
+            (((var1 >> 2) * (var1 >> 2)) >> 13)) >>
+           3) +
+          ((((int32_t)hbmp280->dig_P2) * var1) >> 1)) >>
+         18;
+  var1 = ((32768 + var1) * ((int32_t)hbmp280->dig_P1)) >> 15;
+
+  if (var1 == 0) {
+    return 0;
+  }
+
+  p = (((uint32_t)(1048576 - adc_P)) - (uint32_t)(var2 >> 12)) * 3125;
+  if (p < 0x80000000) {
+    p = (p << 1) / ((uint32_t)var1);
+  } else {
+    p = (p / (uint32_t)var1) * 2;
+  }
+  var1 = (((int32_t)hbmp280->dig_P9) *
+          ((int32_t)(((p >> 3) * (p >> 3)) >> 13))) >>
+         12;
+  var2 = (((int32_t)(p >> 2)) * ((int32_t)hbmp280->dig_P8)) >> 13;
+  p = (uint32_t)((int32_t)p + ((var1 + var2 + hbmp280->dig_P7) >> 4));
+
+  return p << 8;
+}
+#else
+/* Compensation formula from BMP280 datasheet, returns pressure in Pa as
+ * unsigned Q24.8 or 0 if the calibration data would cause division by zero */
+static uint32_t
+BMP280_CompensatePressure(const BMP280_HandleTypeDef *hbmp280, int32_t t_fine,
+                          int32_t adc_P) {
+  int64_t var1, var2, p;
+
+  var1 = ((int64_t)t_fine) - 128000;
+  var2 = var1 * var1 * (int64_t)hbmp280->dig_P6;
+  var2 = var2 + ((var1 * (int64_t)hbmp280->dig_P5) << 17);
+  var2 = var2 + (((int64_t)hbmp280->dig_P4) << 35);
+  var1 = ((var1 * var1 * (int64_t)hbmp280->dig_P3) >> 8) +
+         ((var1 * (int64_t)hbmp280->dig_P2) << 12);
+  var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)hbmp280->dig_P1) >> 33;
+
+  if (var1 == 0) {
+    return 0;
+  }
+
+  p = 1048576 - adc_P;
+  p = (((p << 31) - var2) * 3125) / var1;
+  var1 = (((int64_t)hbmp280->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+  var2 = (((int64_t)hbmp280->dig_P8) * p) >> 19;
+  p = ((p + var1 + var2) >> 8) + (((int64_t)hbmp280->dig_P7) << 4);
+
+  return (uint32_t)p;
+}
+#endif
+
+/* Unpack 20-bit ADC value from MSB, LSB and XLSB registers */
+static int32_t BMP280_UnpackRaw(const uint8_t *data) {
+  return ((int32_t)data[0] << 12) | ((int32_t)data[1] << 4) |
+         ((int32_t)data[2] >> 4);
+}
+
+/* Compensate a press_msb..temp_xlsb burst into 0.01 degC and Q24.8 Pa */
+static HAL_StatusTypeDef BMP280_CompensateAll(BMP280_HandleTypeDef *hbmp280,
+                                              const uint8_t *data,
+                                              int32_t *temperature,
+                                              uint32_t *pressure) {
+  int32_t adc_T, adc_P;
+  uint32_t p;
+
+  adc_P = BMP280_UnpackRaw(&data[0]);
+  adc_T = BMP280_UnpackRaw(&data[3]);
+
+  /* Temperature first (t_fine is needed for pressure compensation) */
+  *temperature = BMP280_CompensateTemperature(hbmp280, adc_T);
+
+  p = BMP280_CompensatePressure(hbmp280, hbmp280->t_fine, adc_P);
+  if (p == 0) {
+    return HAL_ERROR;
+  }
+
+  *pressure = p;
+
+  return HAL_OK;
 }
 
 HAL_StatusTypeDef BMP280_ReadTemperature(BMP280_HandleTypeDef *hbmp280,
                                          float *temperature) {
   uint8_t data[3];
   int32_t adc_T;
-  int32_t var1, var2;
   HAL_StatusTypeDef status;
 
   status =
@@ -92,21 +236,9 @@ HAL_StatusTypeDef BMP280_ReadTemperature(BMP280_HandleTypeDef *hbmp280,
     return status;
   }
 
-  adc_T = ((int32_t)data[0] << 12) | ((int32_t)data[1] << 4) |
-          ((int32_t)data[2] >> 4);
-
-  /* Compensation formula from BMP280 datasheet */
-  var1 = ((((adc_T >> 3) - ((int32_t)hbmp280->dig_T1 << 1))) *
-          ((int32_t)hbmp280->dig_T2)) >>
-         11;
-  var2 = (((((adc_T >> 4) - ((int32_t)hbmp280->dig_T1)) *
-            ((adc_T >> 4) - ((int32_t)hbmp280->dig_T1))) >>
-           12) *
-          ((int32_t)hbmp280->dig_T3)) >>
-         14;
+  adc_T = BMP280_UnpackRaw(data);
 
-  hbmp280->t_fine = var1 + var2;
-  *temperature = ((hbmp280->t_fine * 5 + 128) >> 8) / 100.0f;
+  *temperature = BMP280_CompensateTemperature(hbmp280, adc_T) / 100.0f;
 
   return HAL_OK;
 }
@@ -115,7 +247,7 @@ HAL_StatusTypeDef BMP280_ReadPressure(BMP280_HandleTypeDef *hbmp280,
                                       float *pressure) {
   uint8_t data[3];
   int32_t adc_P;
-  int64_t var1, var2, p;
+  uint32_t p;
   HAL_StatusTypeDef status;
 
   status =
@@ -125,44 +257,509 @@ HAL_StatusTypeDef BMP280_ReadPressure(BMP280_HandleTypeDef *hbmp280,
     return status;
   }
 
-  adc_P = ((int32_t)data[0] << 12) | ((int32_t)data[1] << 4) |
-          ((int32_t)data[2] >> 4);
-
-  /* Compensation formula from BMP280 datasheet */
-  var1 = ((int64_t)hbmp280->t_fine) - 128000;
-  var2 = var1 * var1 * (int64_t)hbmp280->dig_P6;
-  var2 = var2 + ((var1 * (int64_t)hbmp280->dig_P5) << 17);
-  var2 = var2 + (((int64_t)hbmp280->dig_P4) << 35);
-  var1 = ((var1 * var1 * (int64_t)hbmp280->dig_P3) >> 8) +
-         ((var1 * (int64_t)hbmp280->dig_P2) << 12);
-  var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)hbmp280->dig_P1) >> 33;
+  adc_P = BMP280_UnpackRaw(data);
 
-  if (var1 == 0) {
+  p = BMP280_CompensatePressure(hbmp280, hbmp280->t_fine, adc_P);
+  if (p == 0) {
     return HAL_ERROR;
   }
 
-  p = 1048576 - adc_P;
-  p = (((p << 31) - var2) * 3125) / var1;
-  var1 = (((int64_t)hbmp280->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
-  var2 = (((int64_t)hbmp280->dig_P8) * p) >> 19;
-  p = ((p + var1 + var2) >> 8) + (((int64_t)hbmp280->dig_P7) << 4);
-
   *pressure = (float)p / 256.0f;
 
   return HAL_OK;
 }
 
+/**
+ * @brief Read temperature and pressure in a single burst transaction
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @param temperature Pointer to store temperature in 0.01 degC (2508 = 25.08)
+ * @param pressure Pointer to store pressure in Pa as unsigned Q24.8
+ * (24674867 / 256 = 96386.2 Pa)
+ * @return HAL status
+ * @note Registers 0xF7..0xFC are read at once, so both values come from the
+ * same conversion and the bus is only addressed once. No floating point is
+ * used, so integer-only callers do not need FPU or float printf support.
+ * With BMP280_USE_32BIT_COMPENSATION the pressure resolution is 1 Pa
+ */
+HAL_StatusTypeDef BMP280_ReadAllFixed(BMP280_HandleTypeDef *hbmp280,
+                                      int32_t *temperature,
+                                      uint32_t *pressure) {
+  uint8_t data[BMP280_DATA_REGISTERS_COUNT];
+  HAL_StatusTypeDef status;
+
+  status =
+      HAL_I2C_Mem_Read(hbmp280->hi2c, hbmp280->address, BMP280_REG_PRESS_MSB,
+                       I2C_MEMADD_SIZE_8BIT, data, BMP280_DATA_REGISTERS_COUNT,
+                       1000);
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  return BMP280_CompensateAll(hbmp280, data, temperature, pressure);
+}
+
+/**
+ * @brief Read temperature in degC and pressure in Pa in a single burst
+ * transaction
+ */
 HAL_StatusTypeDef BMP280_ReadAll(BMP280_HandleTypeDef *hbmp280,
                                  float *temperature, float *pressure) {
+  int32_t temperature_fixed;
+  uint32_t pressure_fixed;
+  HAL_StatusTypeDef status;
+
+  status = BMP280_ReadAllFixed(hbmp280, &temperature_fixed, &pressure_fixed);
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  *temperature = temperature_fixed / 100.0f;
+  *pressure = (float)pressure_fixed / 256.0f;
+
+  return HAL_OK;
+}
+
+/**
+ * @brief Start a non-blocking burst read of temperature and pressure
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @return HAL status, HAL_BUSY if a read is already pending or the bus is busy
+ * @note Uses DMA when the I2C handle has an RX DMA channel linked, interrupt
+ * mode otherwise. The I2C event/error IRQs must be enabled. Call BMP280_Poll
+ * (e.g. from the main loop or HAL_I2C_MemRxCpltCallback) to collect the result
+ */
+HAL_StatusTypeDef BMP280_StartReadAll(BMP280_HandleTypeDef *hbmp280) {
   HAL_StatusTypeDef status;
 
-  /* Read temperature first (needed for pressure compensation) */
-  status = BMP280_ReadTemperature(hbmp280, temperature);
+  if (hbmp280->read_pending) {
+    return HAL_BUSY;
+  }
+
+  if (hbmp280->hi2c->hdmarx != NULL) {
+    status = HAL_I2C_Mem_Read_DMA(hbmp280->hi2c, hbmp280->address,
+                                  BMP280_REG_PRESS_MSB, I2C_MEMADD_SIZE_8BIT,
+                                  hbmp280->rx_buffer,
+                                  BMP280_DATA_REGISTERS_COUNT);
+  } else {
+    status = HAL_I2C_Mem_Read_IT(hbmp280->hi2c, hbmp280->address,
+                                 BMP280_REG_PRESS_MSB, I2C_MEMADD_SIZE_8BIT,
+                                 hbmp280->rx_buffer,
+                                 BMP280_DATA_REGISTERS_COUNT);
+  }
+
   if (status != HAL_OK) {
     return status;
   }
 
-  status = BMP280_ReadPressure(hbmp280, pressure);
+  hbmp280->read_pending = 1;
+
+  return HAL_OK;
+}
+
+/**
+ * @brief Collect the result of a read started with BMP280_StartReadAll
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @param temperature Pointer to store temperature in 0.01 degC
+ * @param pressure Pointer to store pressure in Pa as unsigned Q24.8
+ * @return HAL_BUSY while the transfer is in progress, HAL_OK when values were
+ * stored, HAL_ERROR if the transfer failed or no read was started
+ */
+HAL_StatusTypeDef BMP280_Poll(BMP280_HandleTypeDef *hbmp280,
+                              int32_t *temperature, uint32_t *pressure) {
+  if (!hbmp280->read_pending) {
+    return HAL_ERROR;
+  }
+
+  if (HAL_I2C_GetState(hbmp280->hi2c) != HAL_I2C_STATE_READY) {
+    return HAL_BUSY;
+  }
+
+  hbmp280->read_pending = 0;
+
+  if (HAL_I2C_GetError(hbmp280->hi2c) != HAL_I2C_ERROR_NONE) {
+    return HAL_ERROR;
+  }
+
+  return BMP280_CompensateAll(hbmp280, hbmp280->rx_buffer, temperature,
+                              pressure);
+}
+
+/* Number of samples taken for an oversampling setting (0 for skipped) */
+static uint32_t BMP280_OversamplingCount(uint8_t oversamp) {
+  if (oversamp == BMP280_OVERSAMPLING_SKIP) {
+    return 0;
+  }
+
+  if (oversamp >= BMP280_OVERSAMPLING_16X) {
+    return 16;
+  }
+
+  return 1U << (oversamp - 1);
+}
+
+/**
+ * @brief Get maximum measurement time for the configured oversampling
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @return Maximum measurement time in microseconds
+ * @note Datasheet: t = 1.25 + 2.3 * osrs_t + (2.3 * osrs_p + 0.575) ms, where
+ * the pressure term is omitted when pressure measurement is skipped
+ */
+uint32_t BMP280_GetMeasurementTime(BMP280_HandleTypeDef *hbmp280) {
+  uint32_t osrs_t = BMP280_OversamplingCount(hbmp280->temp_oversamp);
+  uint32_t osrs_p = BMP280_OversamplingCount(hbmp280->press_oversamp);
+  uint32_t time_us =
+      BMP280_MEAS_TIME_BASE_US + BMP280_MEAS_TIME_SAMPLE_US * osrs_t;
+
+  if (osrs_p != 0) {
+    time_us += BMP280_MEAS_TIME_SAMPLE_US * osrs_p + BMP280_MEAS_TIME_PRESS_US;
+  }
+
+  return time_us;
+}
+
+HAL_StatusTypeDef BMP280_ReadStatus(BMP280_HandleTypeDef *hbmp280,
+                                    uint8_t *status_reg) {
+  return HAL_I2C_Mem_Read(hbmp280->hi2c, hbmp280->address, BMP280_REG_STATUS,
+                          I2C_MEMADD_SIZE_8BIT, status_reg, 1, 1000);
+}
+
+/**
+ * @brief Start a single conversion in forced mode
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @return HAL status
+ * @note Uses oversampling set by the last BMP280_Configure call. The sensor
+ * returns to sleep mode once the conversion is finished
+ */
+HAL_StatusTypeDef BMP280_TriggerForced(BMP280_HandleTypeDef *hbmp280) {
+  uint8_t ctrl_meas_reg_value;
+
+  ctrl_meas_reg_value = (hbmp280->temp_oversamp << 5) |
+                        (hbmp280->press_oversamp << 2) | BMP280_MODE_FORCED;
+
+  return HAL_I2C_Mem_Write(hbmp280->hi2c, hbmp280->address,
+                           BMP280_REG_CTRL_MEAS, I2C_MEMADD_SIZE_8BIT,
+                           &ctrl_meas_reg_value, 1, 1000);
+}
+
+/**
+ * @brief Wait until conversion is finished (measuring bit cleared)
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @param max_retries Maximum number of status reads
+ * @param delay_ms Delay between retries in milliseconds
+ * @return HAL_OK if conversion finished, HAL_TIMEOUT if max retries exceeded,
+ *         or other HAL error code if status read fails
+ */
+HAL_StatusTypeDef BMP280_WaitUntilReady(BMP280_HandleTypeDef *hbmp280,
+                                        uint8_t max_retries,
+                                        uint16_t delay_ms) {
+  HAL_StatusTypeDef status;
+  uint8_t status_reg;
+  uint8_t retry_count = 0;
+
+  while (retry_count < max_retries) {
+    status = BMP280_ReadStatus(hbmp280, &status_reg);
+    if (status != HAL_OK) {
+      return status;
+    }
+
+    if (!(status_reg & BMP280_STATUS_MEASURING_BIT)) {
+      return HAL_OK;
+    }
+
+    sleep_ms(delay_ms);
+    retry_count++;
+  }
+
+  return HAL_TIMEOUT;
+}
+
+/**
+ * @brief Run one forced mode conversion and read the result
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @param temperature Pointer to store temperature in 0.01 degC
+ * @param pressure Pointer to store pressure in Pa as unsigned Q24.8
+ * @return HAL status
+ * @note Waits for the datasheet maximum measurement time of the configured
+ * oversampling, confirms the measuring bit is cleared and burst-reads the
+ * result. The sensor sleeps between calls, the lowest energy per sample mode
+ */
+HAL_StatusTypeDef BMP280_MeasureForced(BMP280_HandleTypeDef *hbmp280,
+                                       int32_t *temperature,
+                                       uint32_t *pressure) {
+  HAL_StatusTypeDef status;
+
+  status = BMP280_TriggerForced(hbmp280);
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  sleep_ms((BMP280_GetMeasurementTime(hbmp280) + 999) / 1000);
+
+  status = BMP280_WaitUntilReady(hbmp280, 5, 1);
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  return BMP280_ReadAllFixed(hbmp280, temperature, pressure);
+}
+
+/**
+ * @brief Run one forced mode conversion on several sensors sharing a bus
+ * @param hbmp280 Array of pointers to BMP280 handle structures (e.g. sensors
+ * at BMP280_ADDRESS_0 and BMP280_ADDRESS_1)
+ * @param count Number of sensors
+ * @param temperature Array of count entries to store temperature in 0.01 degC
+ * @param pressure Array of count entries to store pressure in Pa as Q24.8
+ * @return HAL status of the first failing transaction, HAL_OK otherwise
+ * @note All conversions are started back to back, so the sensors convert in
+ * parallel and only the longest measurement time is waited for once. Results
+ * are then burst-read in sequence
+ */
+HAL_StatusTypeDef BMP280_MeasureForcedGroup(BMP280_HandleTypeDef *hbmp280[],
+                                            uint8_t count,
+                                            int32_t temperature[],
+                                            uint32_t pressure[]) {
+  HAL_StatusTypeDef status;
+  uint32_t time_us;
+  uint32_t max_time_us = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    status = BMP280_TriggerForced(hbmp280[i]);
+    if (status != HAL_OK) {
+      return status;
+    }
+
+    time_us = BMP280_GetMeasurementTime(hbmp280[i]);
+    if (time_us > max_time_us) {
+      max_time_us = time_us;
+    }
+  }
+
+  sleep_ms((max_time_us + 999) / 1000);
+
+  for (uint8_t i = 0; i < count; i++) {
+    status = BMP280_WaitUntilReady(hbmp280[i], 5, 1);
+    if (status != HAL_OK) {
+      return status;
+    }
+
+    status = BMP280_ReadAllFixed(hbmp280[i], &temperature[i], &pressure[i]);
+    if (status != HAL_OK) {
+      return status;
+    }
+  }
+
+  return HAL_OK;
+}
+
+/**
+ * @brief Compensate an array of raw data bursts (press_msb..temp_xlsb)
+ * @param hbmp280 Pointer to BMP280 handle structure with calibration data
+ * @param raw Raw bursts as read from registers 0xF7..0xFC
+ * @param n Number of samples
+ * @param temperature Array of n entries to store temperature in 0.01 degC
+ * @param pressure Array of n entries to store pressure in Pa as unsigned Q24.8
+ * (0 if calibration data would cause division by zero)
+ * @note Pure function, does not touch the bus or the handle. Temperature is
+ * computed in a separate branch-free 32-bit pass with t_fine kept in the
+ * temperature array, so the compiler can vectorise it
+ */
+void BMP280_CompensateBatch(const BMP280_HandleTypeDef *hbmp280,
+                            const uint8_t raw[][BMP280_DATA_REGISTERS_COUNT],
+                            size_t n, int32_t *temperature,
+                            uint32_t *pressure) {
+  for (size_t i = 0; i < n; i++) {
+    temperature[i] =
+        BMP280_CalculateTFine(hbmp280, BMP280_UnpackRaw(&raw[i][3]));
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    pressure[i] = BMP280_CompensatePressure(hbmp280, temperature[i],
+                                            BMP280_UnpackRaw(&raw[i][0]));
+    temperature[i] = BMP280_TFineToTemperature(temperature[i]);
+  }
+}
+
+/* FNV-1a checksum over the calibration record, excluding the checksum field */
+static uint32_t
+BMP280_CalibrationChecksum(const BMP280_CalibrationTypeDef *calibration) {
+  const uint8_t *data = (const uint8_t *)calibration;
+  uint32_t hash = 0x811C9DC5;
+
+  for (size_t i = 0; i < offsetof(BMP280_CalibrationTypeDef, checksum); i++) {
+    hash ^= data[i];
+    hash *= 0x01000193;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief Restore calibration data from the flash cache
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @return HAL_OK if a valid record for this address was restored, HAL_ERROR
+ * otherwise, or the HAL status of a failed chip ID read
+ * @note Without BMP280_CALIBRATION_CHECK_CHIP_ID nothing is read from the
+ * sensor. A replaced sensor at the same address keeps the old calibration
+ * until the record is rewritten with BMP280_SaveCalibration
+ */
+HAL_StatusTypeDef BMP280_LoadCalibration(BMP280_HandleTypeDef *hbmp280) {
+  const BMP280_CalibrationTypeDef *flash_calibration =
+      (const BMP280_CalibrationTypeDef *)(uintptr_t)
+          hbmp280->calibration_flash_address;
+
+  if (flash_calibration->magic != BMP280_CALIBRATION_STRUCT_MAGIC) {
+    return HAL_ERROR;
+  }
+
+  if (flash_calibration->checksum !=
+      BMP280_CalibrationChecksum(flash_calibration)) {
+    return HAL_ERROR;
+  }
+
+  if (flash_calibration->address != hbmp280->address) {
+    return HAL_ERROR;
+  }
+
+#if BMP280_CALIBRATION_CHECK_CHIP_ID
+  uint8_t chip_id;
+  HAL_StatusTypeDef status;
+
+  status = HAL_I2C_Mem_Read(hbmp280->hi2c, hbmp280->address, BMP280_REG_CHIP_ID,
+                            I2C_MEMADD_SIZE_8BIT, &chip_id, 1, 1000);
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  if (chip_id != flash_calibration->chip_id) {
+    return HAL_ERROR;
+  }
+#endif
+
+  hbmp280->chip_id = flash_calibration->chip_id;
+  hbmp280->dig_T1 = flash_calibration->dig_T1;
+  hbmp280->dig_T2 = flash_calibration->dig_T2;
+  hbmp280->dig_T3 = flash_calibration->dig_T3;
+  hbmp280->dig_P1 = flash_calibration->dig_P1;
+  hbmp280->dig_P2 = flash_calibration->dig_P2;
+  hbmp280->dig_P3 = flash_calibration->dig_P3;
+  hbmp280->dig_P4 = flash_calibration->dig_P4;
+  hbmp280->dig_P5 = flash_calibration->dig_P5;
+  hbmp280->dig_P6 = flash_calibration->dig_P6;
+  hbmp280->dig_P7 = flash_calibration->dig_P7;
+  hbmp280->dig_P8 = flash_calibration->dig_P8;
+  hbmp280->dig_P9 = flash_calibration->dig_P9;
+
+  return HAL_OK;
+}
+
+/* Bank and bank-relative page of a flash address. With BFB2 set and the
+ * device booted from bank 2 (SYSCFG FB_MODE) the banks trade addresses */
+static void BMP280_FlashPage(uint32_t address, uint32_t *bank,
+                             uint32_t *page) {
+  uint32_t offset = address - FLASH_BASE;
+  uint32_t upper_half = offset >= FLASH_BANK_SIZE;
+  uint32_t swapped = READ_BIT(SYSCFG->MEMRMP, SYSCFG_MEMRMP_FB_MODE) != 0;
+
+  *bank = (upper_half != swapped) ? FLASH_BANK_2 : FLASH_BANK_1;
+  *page = (offset % FLASH_BANK_SIZE) / FLASH_PAGE_SIZE;
+}
+
+/**
+ * @brief Store calibration data of the handle in the flash cache
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @return HAL status
+ * @note Erases the whole flash page at calibration_flash_address, which must
+ * be reserved for this sensor
+ */
+HAL_StatusTypeDef BMP280_SaveCalibration(BMP280_HandleTypeDef *hbmp280) {
+  BMP280_CalibrationTypeDef calibration = {0};
+  FLASH_EraseInitTypeDef eraseInit;
+  uint32_t pageError;
+  HAL_StatusTypeDef status;
+
+  calibration.magic = BMP280_CALIBRATION_STRUCT_MAGIC;
+  calibration.address = hbmp280->address;
+  calibration.chip_id = hbmp280->chip_id;
+  calibration.dig_T1 = hbmp280->dig_T1;
+  calibration.dig_T2 = hbmp280->dig_T2;
+  calibration.dig_T3 = hbmp280->dig_T3;
+  calibration.dig_P1 = hbmp280->dig_P1;
+  calibration.dig_P2 = hbmp280->dig_P2;
+  calibration.dig_P3 = hbmp280->dig_P3;
+  calibration.dig_P4 = hbmp280->dig_P4;
+  calibration.dig_P5 = hbmp280->dig_P5;
+  calibration.dig_P6 = hbmp280->dig_P6;
+  calibration.dig_P7 = hbmp280->dig_P7;
+  calibration.dig_P8 = hbmp280->dig_P8;
+  calibration.dig_P9 = hbmp280->dig_P9;
+  calibration.checksum = BMP280_CalibrationChecksum(&calibration);
+
+  eraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
+  BMP280_FlashPage(hbmp280->calibration_flash_address, &eraseInit.Banks,
+                   &eraseInit.Page);
+  eraseInit.NbPages = 1;
+
+  status = HAL_FLASH_Unlock();
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  // A stale error flag (e.g. PGSERR, OPTVERR) makes the erase fail
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+
+  status = HAL_FLASHEx_Erase(&eraseInit, &pageError);
+
+  const uint8_t *data = (const uint8_t *)&calibration;
+  size_t writes_number = sizeof(BMP280_CalibrationTypeDef) / 8;
+
+  for (size_t i = 0; i < writes_number && status == HAL_OK; i++) {
+    uint64_t doubleword;
+
+    memcpy(&doubleword, &data[i * 8], sizeof(doubleword));
+    status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD,
+                               hbmp280->calibration_flash_address + i * 8,
+                               doubleword);
+  }
+
+  HAL_FLASH_Lock();
 
   return status;
 }
+
+/**
+ * @brief Initialize BMP280 using the flash calibration cache
+ * @param hbmp280 Pointer to BMP280 handle structure
+ * @param hi2c Pointer to I2C handle
+ * @param address I2C address of the sensor
+ * @param calibration_flash_address Start of a flash page reserved for this
+ * sensor, e.g. BMP280_CALIBRATION_FLASH_ADDRESS
+ * @return HAL status
+ * @note A valid record for the address is restored without reading the chip
+ * ID or the trimming registers, see BMP280_CALIBRATION_CHECK_CHIP_ID.
+ * Otherwise falls back to BMP280_Init and stores the calibration read from
+ * the sensor. After replacing the sensor call BMP280_Init and
+ * BMP280_SaveCalibration to rewrite the record
+ */
+HAL_StatusTypeDef BMP280_InitCached(BMP280_HandleTypeDef *hbmp280,
+                                    I2C_HandleTypeDef *hi2c, uint16_t address,
+                                    uint32_t calibration_flash_address) {
+  HAL_StatusTypeDef status;
+
+  hbmp280->hi2c = hi2c;
+  hbmp280->address = address;
+  hbmp280->read_pending = 0;
+  hbmp280->temp_oversamp = BMP280_OVERSAMPLING_SKIP;
+  hbmp280->press_oversamp = BMP280_OVERSAMPLING_SKIP;
+  hbmp280->calibration_flash_address = calibration_flash_address;
+
+  if (BMP280_LoadCalibration(hbmp280) == HAL_OK) {
+    return HAL_OK;
+  }
+
+  status = BMP280_Init(hbmp280, hi2c, address);
+  if (status != HAL_OK) {
+    return status;
+  }
+
+  return BMP280_SaveCalibration(hbmp280);
+}
@@ -2,8 +2,29 @@
 #define BMP280_H
 
 #include "stm32l4xx_hal.h"
+#include <stddef.h>
 #include <stdint.h>
 
+/* Configuration options */
+/**
+ * Pressure compensation backend:
+ * 0 - 64-bit datasheet formula, 1/256 Pa resolution
+ * 1 - 32-bit datasheet formula, 1 Pa resolution, avoids the slow 64-bit
+ *     division (__aeabi_ldivmod) on Cortex-M4
+ */
+#ifndef BMP280_USE_32BIT_COMPENSATION
+#define BMP280_USE_32BIT_COMPENSATION 0
+#endif
+/**
+ * Calibration cache hit:
+ * 0 - restore the record without bus traffic
+ * 1 - read the chip ID first and only restore a record written for the same
+ *     part type (one byte, trimming registers are never read back)
+ */
+#ifndef BMP280_CALIBRATION_CHECK_CHIP_ID
+#define BMP280_CALIBRATION_CHECK_CHIP_ID 0
+#endif
+
 /* BMP280 I2C Address */
 #define BMP280_ADDRESS_0 (0x76 << 1)
 #define BMP280_ADDRESS_1 (0x77 << 1)
@@ -21,9 +42,21 @@
 /* BMP280 Trimming Parameters Registers Count */
 #define BMP280_TRIMM_PARAM_REGISTERS_COUNT 24
 
+/* BMP280 Data Registers Count (press_msb..temp_xlsb) */
+#define BMP280_DATA_REGISTERS_COUNT 6
+
 /* BMP280 Chip ID */
 #define BMP280_CHIP_ID 0x58
 
+/* BMP280 Status Bits */
+#define BMP280_STATUS_MEASURING_BIT (1 << 3)
+#define BMP280_STATUS_IM_UPDATE_BIT (1 << 0)
+
+/* BMP280 Maximum Measurement Time Constants [us] */
+#define BMP280_MEAS_TIME_BASE_US 1250
+#define BMP280_MEAS_TIME_SAMPLE_US 2300
+#define BMP280_MEAS_TIME_PRESS_US 575
+
 /* Standby Time */
 #define BMP280_STANDBY_0_5MS 0x00
 #define BMP280_STANDBY_62_5MS 0x01
@@ -54,10 +87,44 @@
 #define BMP280_MODE_FORCED 0x01
 #define BMP280_MODE_NORMAL 0x03
 
+/* BMP280 Calibration Cache */
+#define BMP280_CALIBRATION_STRUCT_MAGIC 0x42503238 // "BP28"
+
+/* Flash reserved for calibration records by the CALIB region of the linker
+ * script, one page per sensor. The first page belongs to HW390 */
+extern uint8_t _scalib[];
+#define BMP280_CALIBRATION_FLASH_ADDRESS                                       \
+  ((uint32_t)(uintptr_t)&_scalib[FLASH_PAGE_SIZE])
+
+/* Calibration record stored in flash, size must be a multiple of 8 bytes.
+ * Keyed by I2C address, chip_id is the value BMP280_Init read */
+typedef struct {
+  uint32_t magic; // To identify if it is a correct structure
+  uint16_t address;
+  uint8_t chip_id;
+  uint8_t reserved[5];
+
+  uint16_t dig_T1;
+  int16_t dig_T2;
+  int16_t dig_T3;
+  uint16_t dig_P1;
+  int16_t dig_P2;
+  int16_t dig_P3;
+  int16_t dig_P4;
+  int16_t dig_P5;
+  int16_t dig_P6;
+  int16_t dig_P7;
+  int16_t dig_P8;
+  int16_t dig_P9;
+
+  uint32_t checksum; // FNV-1a of all preceding fields
+} BMP280_CalibrationTypeDef;
+
 /* BMP280 Handle Structure */
 typedef struct {
   I2C_HandleTypeDef *hi2c;
   uint16_t address;
+  uint8_t chip_id; // Read by BMP280_Init
 
   /* Calibration data */
   uint16_t dig_T1;
@@ -74,11 +141,27 @@ typedef struct {
   int16_t dig_P9;
 
   int32_t t_fine; // Used in pressure calculation
+
+  /* Oversampling set by BMP280_Configure, used for forced mode */
+  uint8_t temp_oversamp;
+  uint8_t press_oversamp;
+
+  /* Asynchronous read */
+  uint8_t rx_buffer[BMP280_DATA_REGISTERS_COUNT];
+  volatile uint8_t read_pending;
+
+  /* Calibration cache flash page, see BMP280_InitCached */
+  uint32_t calibration_flash_address;
 } BMP280_HandleTypeDef;
 
 /* Function Prototypes */
 HAL_StatusTypeDef BMP280_Init(BMP280_HandleTypeDef *hbmp280,
                               I2C_HandleTypeDef *hi2c, uint16_t address);
+HAL_StatusTypeDef BMP280_InitCached(BMP280_HandleTypeDef *hbmp280,
+                                    I2C_HandleTypeDef *hi2c, uint16_t address,
+                                    uint32_t calibration_flash_address);
+HAL_StatusTypeDef BMP280_LoadCalibration(BMP280_HandleTypeDef *hbmp280);
+HAL_StatusTypeDef BMP280_SaveCalibration(BMP280_HandleTypeDef *hbmp280);
 HAL_StatusTypeDef BMP280_Configure(BMP280_HandleTypeDef *hbmp280,
                                    uint8_t standby_time, uint8_t filter,
                                    uint8_t temp_oversampling,
@@ -89,5 +172,29 @@ HAL_StatusTypeDef BMP280_ReadPressure(BMP280_HandleTypeDef *hbmp280,
                                       float *pressure);
 HAL_StatusTypeDef BMP280_ReadAll(BMP280_HandleTypeDef *hbmp280,
                                  float *temperature, float *pressure);
+HAL_StatusTypeDef BMP280_ReadAllFixed(BMP280_HandleTypeDef *hbmp280,
+                                      int32_t *temperature,
+                                      uint32_t *pressure);
+HAL_StatusTypeDef BMP280_ReadStatus(BMP280_HandleTypeDef *hbmp280,
+                                    uint8_t *status_reg);
+uint32_t BMP280_GetMeasurementTime(BMP280_HandleTypeDef *hbmp280);
+HAL_StatusTypeDef BMP280_TriggerForced(BMP280_HandleTypeDef *hbmp280);
+HAL_StatusTypeDef BMP280_WaitUntilReady(BMP280_HandleTypeDef *hbmp280,
+                                        uint8_t max_retries,
+                                        uint16_t delay_ms);
+HAL_StatusTypeDef BMP280_MeasureForced(BMP280_HandleTypeDef *hbmp280,
+                                       int32_t *temperature,
+                                       uint32_t *pressure);
+HAL_StatusTypeDef BMP280_MeasureForcedGroup(BMP280_HandleTypeDef *hbmp280[],
+                                            uint8_t count,
+                                            int32_t temperature[],
+                                            uint32_t pressure[]);
+HAL_StatusTypeDef BMP280_StartReadAll(BMP280_HandleTypeDef *hbmp280);
+HAL_StatusTypeDef BMP280_Poll(BMP280_HandleTypeDef *hbmp280,
+                              int32_t *temperature, uint32_t *pressure);
+void BMP280_CompensateBatch(const BMP280_HandleTypeDef *hbmp280,
+                            const uint8_t raw[][BMP280_DATA_REGISTERS_COUNT],
+                            size_t n, int32_t *temperature,
+                            uint32_t *pressure);
 
 #endif
@@ -1,280 +1,1026 @@
 #include "gdm1602a.h"
 #include "delay_us.h"
-#include "gdm1602a_config.h"
 #include <stdarg.h>
-#include <stdio.h>
 #include <string.h>
 
-static uint8_t display_control = 0;
+#if LCD_USE_8BIT_MODE
+#define LCD_DATA_LINE_FIRST GDM1602A_DB0
+#else
+#define LCD_DATA_LINE_FIRST GDM1602A_DB4
+#endif
+
+/* Rows, columns and row start addresses of each GDM1602A_GeometryTypeDef */
+static const struct {
+  uint8_t rows;
+  uint8_t cols;
+  uint8_t row_offset[GDM1602A_MAX_ROWS];
+} lcd_geometries[] = {
+    [GDM1602A_GEOMETRY_16X1] = {1, 16, {0x00}},
+    [GDM1602A_GEOMETRY_16X2] = {2, 16, {0x00, 0x40}},
+    [GDM1602A_GEOMETRY_16X4] = {4, 16, {0x00, 0x40, 0x10, 0x50}},
+    [GDM1602A_GEOMETRY_20X2] = {2, 20, {0x00, 0x40}},
+    [GDM1602A_GEOMETRY_20X4] = {4, 20, {0x00, 0x40, 0x14, 0x54}},
+    [GDM1602A_GEOMETRY_40X2] = {2, 40, {0x00, 0x40}},
+};
+
+/* Address counter value matching no DDRAM cell, the next flush sets it */
+#define LCD_ADDRESS_UNKNOWN 0xFF
 
-static void lcd_write_nibble(uint8_t nibble);
-static void lcd_write_byte(uint8_t data, uint8_t rs);
-static void lcd_instruction(uint8_t cmd);
-static void lcd_write_data(uint8_t data);
-static void lcd_enable_pulse(void);
+#if LCD_USE_DMA_REFRESH
+/* Worst case diff: every other cell changed, one address set per cell, after
+ * all glyphs were loaded and the address counter returned to DDRAM */
+#if LCD_USE_8BIT_MODE
+#define LCD_DMA_WORDS_PER_BYTE (3 + LCD_DMA_IDLE_WORDS)
+#else
+#define LCD_DMA_WORDS_PER_BYTE (6 + LCD_DMA_IDLE_WORDS)
+#endif
+#define LCD_DMA_MAX_CELLS (LCD_DMA_MAX_ROWS * LCD_DMA_MAX_COLS)
+#define LCD_DMA_BUFFER_WORDS                                                   \
+  ((LCD_DMA_MAX_CELLS * 3 / 2 + LCD_DMA_MAX_ROWS +                             \
+    GDM1602A_CGRAM_SLOTS * (GDM1602A_GLYPH_ROWS + 1) + 1) *                    \
+   LCD_DMA_WORDS_PER_BYTE)
+
+#if LCD_DMA_MAX_ROWS > GDM1602A_MAX_ROWS || LCD_DMA_MAX_COLS > GDM1602A_MAX_COLS
+#error "LCD_DMA_MAX_ROWS/COLS exceed the largest supported display"
+#endif
+
+/* One TIM6/DMA channel and word buffer, one display refreshed at a time */
+static DMA_HandleTypeDef hdma_lcd;
+static GDM1602A_HandleTypeDef *lcd_dma_owner = NULL;
+static uint32_t lcd_dma_words[LCD_DMA_BUFFER_WORDS];
+static uint16_t lcd_dma_length = 0;
+static volatile bool lcd_dma_busy = false;
+
+/* What the owner's LCD holds once the words are clocked out, committed to the
+ * handle by the transfer complete interrupt */
+static char lcd_dma_frame[LCD_DMA_MAX_CELLS];
+static uint8_t lcd_dma_address;
+static uint8_t lcd_dma_glyphs; // Slots loaded by the transfer
+static uint8_t lcd_dma_glyph[GDM1602A_CGRAM_SLOTS][GDM1602A_GLYPH_ROWS];
+#endif
+
+#if !LCD_USE_8BIT_MODE
+static void lcd_write_nibble(GDM1602A_HandleTypeDef *hlcd, uint8_t nibble);
+#endif
+static void lcd_write_byte(GDM1602A_HandleTypeDef *hlcd, uint8_t data,
+                           uint8_t rs);
+static void lcd_instruction(GDM1602A_HandleTypeDef *hlcd, uint8_t cmd);
+static void lcd_write_data(GDM1602A_HandleTypeDef *hlcd, uint8_t data);
+static void lcd_enable_pulse(GDM1602A_HandleTypeDef *hlcd);
+static void lcd_wait(GDM1602A_HandleTypeDef *hlcd, uint32_t delay);
+#if LCD_USE_RW_PIN
+static uint8_t lcd_read_byte(GDM1602A_HandleTypeDef *hlcd, uint8_t rs);
+#endif
 #if LCD_USE_BUSY_FLAG
-static uint8_t lcd_read_byte(uint8_t rs);
-static bool lcd_is_busy(void);
-static void lcd_wait_while_busy(void);
+static bool lcd_is_busy(GDM1602A_HandleTypeDef *hlcd);
+static bool lcd_wait_while_busy(GDM1602A_HandleTypeDef *hlcd);
 #endif
 
-static void lcd_enable_pulse(void) {
-  HAL_GPIO_WritePin(LCD_E_PORT, LCD_E_PIN, GPIO_PIN_SET);
+/* Synchronous bus access is refused while a background refresh drives the
+ * pins */
+static bool lcd_bus_busy(void) {
+#if LCD_USE_DMA_REFRESH
+  return lcd_dma_busy;
+#else
+  return false;
+#endif
+}
+
+static void lcd_pin_write(const GDM1602A_PinTypeDef *pin, bool state) {
+  HAL_GPIO_WritePin(pin->port, pin->pin, state ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+static void lcd_enable_pulse(GDM1602A_HandleTypeDef *hlcd) {
+  lcd_pin_write(&hlcd->pins.e, true);
   delay_us(LCD_DELAY_ENABLE);
-  HAL_GPIO_WritePin(LCD_E_PORT, LCD_E_PIN, GPIO_PIN_RESET);
+  lcd_pin_write(&hlcd->pins.e, false);
   delay_us(LCD_DELAY_ENABLE);
 }
 
+#if LCD_DATA_PINS_SAME_PORT
+/* BSRR value for 4 data lines: set the pins of 1 bits, reset those of 0 bits */
+static void lcd_build_bsrr_table(uint32_t table[16],
+                                 const GDM1602A_PinTypeDef *lines) {
+  for (uint8_t value = 0; value < 16; value++) {
+    table[value] = 0;
+
+    for (uint8_t bit = 0; bit < 4; bit++) {
+      if (value & (1 << bit)) {
+        table[value] |= lines[bit].pin;
+      } else {
+        table[value] |= (uint32_t)lines[bit].pin << 16;
+      }
+    }
+  }
+}
+
+/* Check the pin map against LCD_DATA_PINS_SAME_PORT */
+static bool lcd_data_pins_same_port(const GDM1602A_PinMapTypeDef *pins) {
 #if LCD_USE_8BIT_MODE
-static void lcd_write_byte_direct(uint8_t data) {
-  HAL_GPIO_WritePin(LCD_DB0_PORT, LCD_DB0_PIN,
-                    (data & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB1_PORT, LCD_DB1_PIN,
-                    (data & 0x02) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB2_PORT, LCD_DB2_PIN,
-                    (data & 0x04) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB3_PORT, LCD_DB3_PIN,
-                    (data & 0x08) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB4_PORT, LCD_DB4_PIN,
-                    (data & 0x10) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB5_PORT, LCD_DB5_PIN,
-                    (data & 0x20) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB6_PORT, LCD_DB6_PIN,
-                    (data & 0x40) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB7_PORT, LCD_DB7_PIN,
-                    (data & 0x80) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  lcd_enable_pulse();
+  uint8_t first = GDM1602A_DB0;
+#else
+  uint8_t first = GDM1602A_DB4;
+#endif
+
+  for (uint8_t line = first; line < GDM1602A_DB4 + 4; line++) {
+    if (pins->db[line].port != pins->db[GDM1602A_DB4].port) {
+      return false;
+    }
+  }
+
+  return true;
+}
+#endif
+
+#if LCD_USE_8BIT_MODE
+static void lcd_write_byte_direct(GDM1602A_HandleTypeDef *hlcd, uint8_t data) {
+#if LCD_DATA_PINS_SAME_PORT
+  if (hlcd->same_port) {
+    // All 8 data lines change in the same bus cycle
+    hlcd->pins.db[GDM1602A_DB4].port->BSRR =
+        hlcd->bsrr_low[data & 0x0F] | hlcd->bsrr_high[data >> 4];
+    lcd_enable_pulse(hlcd);
+    return;
+  }
+#endif
+
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    lcd_pin_write(&hlcd->pins.db[bit], data & (1 << bit));
+  }
+  lcd_enable_pulse(hlcd);
 }
 #else
-static void lcd_write_nibble(uint8_t nibble) {
-  HAL_GPIO_WritePin(LCD_DB4_PORT, LCD_DB4_PIN,
-                    (nibble & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB5_PORT, LCD_DB5_PIN,
-                    (nibble & 0x02) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB6_PORT, LCD_DB6_PIN,
-                    (nibble & 0x04) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_DB7_PORT, LCD_DB7_PIN,
-                    (nibble & 0x08) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  lcd_enable_pulse();
+static void lcd_write_nibble(GDM1602A_HandleTypeDef *hlcd, uint8_t nibble) {
+#if LCD_DATA_PINS_SAME_PORT
+  if (hlcd->same_port) {
+    hlcd->pins.db[GDM1602A_DB4].port->BSRR = hlcd->bsrr_high[nibble & 0x0F];
+    lcd_enable_pulse(hlcd);
+    return;
+  }
+#endif
+
+  for (uint8_t bit = 0; bit < 4; bit++) {
+    lcd_pin_write(&hlcd->pins.db[GDM1602A_DB4 + bit], nibble & (1 << bit));
+  }
+  lcd_enable_pulse(hlcd);
 }
 #endif
 
-static void lcd_write_byte(uint8_t data, uint8_t rs) {
-  HAL_GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN,
-                    rs ? GPIO_PIN_SET : GPIO_PIN_RESET);
+static void lcd_write_byte(GDM1602A_HandleTypeDef *hlcd, uint8_t data,
+                           uint8_t rs) {
+  lcd_pin_write(&hlcd->pins.rs, rs);
 #if LCD_USE_RW_PIN
-  HAL_GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_RESET);
+  lcd_pin_write(&hlcd->pins.rw, false);
 #endif
 
 #if LCD_USE_8BIT_MODE
-  lcd_write_byte_direct(data);
+  lcd_write_byte_direct(hlcd, data);
 #else
-  lcd_write_nibble(data >> 4);
-  lcd_write_nibble(data & 0x0F);
+  lcd_write_nibble(hlcd, data >> 4);
+  lcd_write_nibble(hlcd, data & 0x0F);
 #endif
 }
 
-static void lcd_instruction(uint8_t instruction) {
-#if LCD_USE_BUSY_FLAG
-  lcd_wait_while_busy();
+static void lcd_instruction(GDM1602A_HandleTypeDef *hlcd,
+                            uint8_t instruction) {
+#if LCD_USE_BUS_STATS
+  uint32_t start = DWT->CYCCNT;
 #endif
-  lcd_write_byte(instruction, 0);
+
+  lcd_write_byte(hlcd, instruction, 0);
 
   if (instruction == GDM1602A_INS_CLEAR || instruction == GDM1602A_INS_HOME) {
-    delay_us(LCD_DELAY_INS_CLEAR_HOME);
+    lcd_wait(hlcd, LCD_DELAY_INS_CLEAR_HOME);
   } else {
-#if !LCD_USE_BUSY_FLAG
-    delay_us(LCD_DELAY_INS);
-#endif
+    lcd_wait(hlcd, LCD_DELAY_INS);
   }
+
+#if LCD_USE_BUS_STATS
+  hlcd->bus_cycles += DWT->CYCCNT - start;
+#endif
 }
 
-static void lcd_write_data(uint8_t data) {
-#if LCD_USE_BUSY_FLAG
-  lcd_wait_while_busy();
+static void lcd_write_data(GDM1602A_HandleTypeDef *hlcd, uint8_t data) {
+#if LCD_USE_BUS_STATS
+  uint32_t start = DWT->CYCCNT;
 #endif
-  lcd_write_byte(data, 1);
-#if !LCD_USE_BUSY_FLAG
-  delay_us(LCD_DELAY_INS);
+
+  lcd_write_byte(hlcd, data, 1);
+  lcd_wait(hlcd, LCD_DELAY_INS);
+
+#if LCD_USE_BUS_STATS
+  hlcd->bus_cycles += DWT->CYCCNT - start;
 #endif
 }
 
-#if LCD_USE_BUSY_FLAG
+#if LCD_USE_RW_PIN
+/* MODER values */
+#define LCD_GPIO_MODE_INPUT 0x0
+#define LCD_GPIO_MODE_OUTPUT 0x1
+
+/* Switch a data pin between input and output with a single MODER update */
+static void lcd_pin_mode(const GDM1602A_PinTypeDef *pin, uint32_t mode) {
+  uint32_t shift = POSITION_VAL(pin->pin) * 2;
+
+  MODIFY_REG(pin->port->MODER, GPIO_MODER_MODE0 << shift, mode << shift);
+}
+
+static void lcd_data_pins_mode(GDM1602A_HandleTypeDef *hlcd, uint32_t mode) {
+  for (uint8_t line = LCD_DATA_LINE_FIRST; line < 8; line++) {
+    lcd_pin_mode(&hlcd->pins.db[line], mode);
+  }
+}
+
+/* Read 4 data lines starting at first as a nibble */
+static uint8_t lcd_read_nibble(GDM1602A_HandleTypeDef *hlcd, uint8_t first) {
+  uint8_t nibble = 0;
+
+  for (uint8_t bit = 0; bit < 4; bit++) {
+    const GDM1602A_PinTypeDef *line = &hlcd->pins.db[first + bit];
+
+    if (line->port->IDR & line->pin) {
+      nibble |= 1 << bit;
+    }
+  }
+
+  return nibble;
+}
+
 /* Read byte from LCD (requires R/W pin) */
-/**
- * ! WORK FOR 8 BIT ??
- */
-static uint8_t lcd_read_byte(uint8_t rs) {
-  uint8_t data = 0;
-
-  GPIO_InitTypeDef GPIO_InitStruct = {0};
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
-  GPIO_InitStruct.Pull = GPIO_NOPULL;
-  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-
-  GPIO_InitStruct.Pin = LCD_DB4_PIN;
-  HAL_GPIO_Init(LCD_DB4_PORT, &GPIO_InitStruct);
-  GPIO_InitStruct.Pin = LCD_DB5_PIN;
-  HAL_GPIO_Init(LCD_DB5_PORT, &GPIO_InitStruct);
-  GPIO_InitStruct.Pin = LCD_DB6_PIN;
-  HAL_GPIO_Init(LCD_DB6_PORT, &GPIO_InitStruct);
-  GPIO_InitStruct.Pin = LCD_DB7_PIN;
-  HAL_GPIO_Init(LCD_DB7_PORT, &GPIO_InitStruct);
-
-  // Set RS and R/W
-  HAL_GPIO_WritePin(LCD_RS_PORT, LCD_RS_PIN,
-                    rs ? GPIO_PIN_SET : GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(LCD_RW_PORT, LCD_RW_PIN, GPIO_PIN_SET);
-
-  // Read high nibble
-  HAL_GPIO_WritePin(LCD_E_PORT, LCD_E_PIN, GPIO_PIN_SET);
-  delay_us(LCD_DELAY_ENABLE);
-  data = (HAL_GPIO_ReadPin(LCD_DB7_PORT, LCD_DB7_PIN) << 3) |
-         (HAL_GPIO_ReadPin(LCD_DB6_PORT, LCD_DB6_PIN) << 2) |
-         (HAL_GPIO_ReadPin(LCD_DB5_PORT, LCD_DB5_PIN) << 1) |
-         (HAL_GPIO_ReadPin(LCD_DB4_PORT, LCD_DB4_PIN));
-  HAL_GPIO_WritePin(LCD_E_PORT, LCD_E_PIN, GPIO_PIN_RESET);
-  delay_us(LCD_DELAY_ENABLE);
+static uint8_t lcd_read_byte(GDM1602A_HandleTypeDef *hlcd, uint8_t rs) {
+  uint8_t data;
 
-  data <<= 4;
+  lcd_data_pins_mode(hlcd, LCD_GPIO_MODE_INPUT);
 
-  // Read low nibble
-  HAL_GPIO_WritePin(LCD_E_PORT, LCD_E_PIN, GPIO_PIN_SET);
+  lcd_pin_write(&hlcd->pins.rs, rs);
+  lcd_pin_write(&hlcd->pins.rw, true);
+
+  lcd_pin_write(&hlcd->pins.e, true);
+  delay_us(LCD_DELAY_ENABLE);
+#if LCD_USE_8BIT_MODE
+  data = (uint8_t)(lcd_read_nibble(hlcd, GDM1602A_DB4) << 4) |
+         lcd_read_nibble(hlcd, GDM1602A_DB0);
+  lcd_pin_write(&hlcd->pins.e, false);
   delay_us(LCD_DELAY_ENABLE);
-  data |= (HAL_GPIO_ReadPin(LCD_DB7_PORT, LCD_DB7_PIN) << 3) |
-          (HAL_GPIO_ReadPin(LCD_DB6_PORT, LCD_DB6_PIN) << 2) |
-          (HAL_GPIO_ReadPin(LCD_DB5_PORT, LCD_DB5_PIN) << 1) |
-          (HAL_GPIO_ReadPin(LCD_DB4_PORT, LCD_DB4_PIN));
-  HAL_GPIO_WritePin(LCD_E_PORT, LCD_E_PIN, GPIO_PIN_RESET);
+#else
+  // High nibble first, low nibble on the second enable pulse
+  data = (uint8_t)(lcd_read_nibble(hlcd, GDM1602A_DB4) << 4);
+  lcd_pin_write(&hlcd->pins.e, false);
   delay_us(LCD_DELAY_ENABLE);
 
-  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-  GPIO_InitStruct.Pull = GPIO_NOPULL;
-  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  lcd_pin_write(&hlcd->pins.e, true);
+  delay_us(LCD_DELAY_ENABLE);
+  data |= lcd_read_nibble(hlcd, GDM1602A_DB4);
+  lcd_pin_write(&hlcd->pins.e, false);
+  delay_us(LCD_DELAY_ENABLE);
+#endif
 
-  GPIO_InitStruct.Pin = LCD_DB4_PIN;
-  HAL_GPIO_Init(LCD_DB4_PORT, &GPIO_InitStruct);
-  GPIO_InitStruct.Pin = LCD_DB5_PIN;
-  HAL_GPIO_Init(LCD_DB5_PORT, &GPIO_InitStruct);
-  GPIO_InitStruct.Pin = LCD_DB6_PIN;
-  HAL_GPIO_Init(LCD_DB6_PORT, &GPIO_InitStruct);
-  GPIO_InitStruct.Pin = LCD_DB7_PIN;
-  HAL_GPIO_Init(LCD_DB7_PORT, &GPIO_InitStruct);
+  lcd_pin_write(&hlcd->pins.rw, false);
+  lcd_data_pins_mode(hlcd, LCD_GPIO_MODE_OUTPUT);
 
   return data;
 }
+#endif
 
-static bool lcd_is_busy(void) {
-  uint8_t status = lcd_read_byte(0);
+#if LCD_USE_BUSY_FLAG
+static bool lcd_is_busy(GDM1602A_HandleTypeDef *hlcd) {
+  uint8_t status = lcd_read_byte(hlcd, 0);
   return (status & GDM1602A_BUSY_FLAG) != 0;
 }
 
-static void lcd_wait_while_busy(void) {
-  uint32_t timeout = 10000;
-  while (lcd_is_busy() && timeout--) {
+/* Returns false if the busy flag did not clear in time */
+static bool lcd_wait_while_busy(GDM1602A_HandleTypeDef *hlcd) {
+  uint32_t timeout = LCD_BUSY_TIMEOUT;
+
+  while (lcd_is_busy(hlcd)) {
+    if (timeout == 0) {
+      return false;
+    }
+
+    timeout--;
     delay_us(1);
   }
+
+  return true;
 }
 #endif
 
-void gdm1602a_init(void) {
+/* Wait for the last instruction, fixed delay unless the busy flag is used */
+static void lcd_wait(GDM1602A_HandleTypeDef *hlcd, uint32_t delay) {
+#if LCD_USE_BUSY_FLAG
+  if (lcd_wait_while_busy(hlcd)) {
+    return;
+  }
+#else
+  (void)hlcd;
+#endif
+  delay_us(delay);
+}
+
+/* Address counter after a write or cursor shift at address */
+static uint8_t lcd_address_next(GDM1602A_HandleTypeDef *hlcd, uint8_t address,
+                                bool increment) {
+  if (address == LCD_ADDRESS_UNKNOWN) {
+    return address;
+  }
+
+  if (hlcd->rows == 1) {
+    // 1-line mode: one 80 cell line
+    if (increment) {
+      return (address + 1) % GDM1602A_DDRAM_SIZE;
+    }
+    return (address == 0) ? GDM1602A_DDRAM_SIZE - 1 : address - 1;
+  }
+
+  if (increment) {
+    if (address == GDM1602A_LINE1_START + GDM1602A_DDRAM_LINE_LENGTH - 1) {
+      return GDM1602A_LINE2_START;
+    }
+    if (address == GDM1602A_LINE2_START + GDM1602A_DDRAM_LINE_LENGTH - 1) {
+      return GDM1602A_LINE1_START;
+    }
+    return address + 1;
+  }
+
+  if (address == GDM1602A_LINE1_START) {
+    return GDM1602A_LINE2_START + GDM1602A_DDRAM_LINE_LENGTH - 1;
+  }
+  if (address == GDM1602A_LINE2_START) {
+    return GDM1602A_LINE1_START + GDM1602A_DDRAM_LINE_LENGTH - 1;
+  }
+  return address - 1;
+}
+
+/* Map DDRAM address to a framebuffer index, false if it is off screen */
+static bool lcd_address_to_cell(GDM1602A_HandleTypeDef *hlcd, uint8_t address,
+                                uint8_t *cell) {
+  for (uint8_t row = 0; row < hlcd->rows; row++) {
+    uint8_t col = address - hlcd->row_offset[row];
+
+    if (col < hlcd->cols) {
+      *cell = row * hlcd->cols + col;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void lcd_set_address(GDM1602A_HandleTypeDef *hlcd, uint8_t address) {
+  lcd_instruction(hlcd, GDM1602A_INS_SET_DDRAM_ADDR | address);
+  hlcd->address = address;
+}
+
+void gdm1602a_init(GDM1602A_HandleTypeDef *hlcd,
+                   const GDM1602A_PinMapTypeDef *pins,
+                   GDM1602A_GeometryTypeDef geometry) {
+  uint8_t lines;
+
+  hlcd->pins = *pins;
+  hlcd->display_control = 0;
+  hlcd->rows = lcd_geometries[geometry].rows;
+  hlcd->cols = lcd_geometries[geometry].cols;
+  memcpy(hlcd->row_offset, lcd_geometries[geometry].row_offset,
+         sizeof(hlcd->row_offset));
+  lines = (hlcd->rows == 1) ? GDM1602A_FS_1LINE : GDM1602A_FS_2LINE;
+  hlcd->address = GDM1602A_LINE1_START;
+  hlcd->glyph_clock = 0;
+  hlcd->glyph_valid = 0;
+  hlcd->glyph_pending = 0;
+  memset(hlcd->glyph_used, 0, sizeof(hlcd->glyph_used));
+
+#if LCD_DATA_PINS_SAME_PORT
+  // A pin map spread over several ports falls back to pin by pin writes
+  hlcd->same_port = lcd_data_pins_same_port(pins);
+#if LCD_USE_8BIT_MODE
+  lcd_build_bsrr_table(hlcd->bsrr_low, &hlcd->pins.db[GDM1602A_DB0]);
+#endif
+  lcd_build_bsrr_table(hlcd->bsrr_high, &hlcd->pins.db[GDM1602A_DB4]);
+#endif
+
   // Initialization sequence from hd44780u datasheet
+  // Busy flag can not be checked until the interface width is set
+
+#if LCD_USE_RW_PIN
+  lcd_pin_write(&hlcd->pins.rw, false);
+#endif
 
   delay_us(LCD_DELAY_INIT_1);
 
 #if LCD_USE_8BIT_MODE
-  lcd_write_byte_direct(0x30);
+  lcd_write_byte_direct(hlcd, 0x30);
   delay_us(LCD_DELAY_INIT_2);
 
-  lcd_write_byte_direct(0x30);
+  lcd_write_byte_direct(hlcd, 0x30);
   delay_us(LCD_DELAY_INIT_3);
 
-  lcd_write_byte_direct(0x30);
+  lcd_write_byte_direct(hlcd, 0x30);
   delay_us(LCD_DELAY_INIT_3);
 
-  // Function set: 8-bit mode, 2 lines, 5x8 font
-  lcd_instruction(GDM1602A_INS_FUNCTION_SET | GDM1602A_FS_8BIT |
-                  GDM1602A_FS_2LINE | GDM1602A_FS_5x8FONT);
+  // Function set: 8-bit mode, 1 or 2 lines, 5x8 font
+  lcd_instruction(hlcd, GDM1602A_INS_FUNCTION_SET | GDM1602A_FS_8BIT | lines |
+                            GDM1602A_FS_5x8FONT);
 #else
-  lcd_write_nibble(0x03);
+  lcd_write_nibble(hlcd, 0x03);
   delay_us(LCD_DELAY_INIT_2);
 
-  lcd_write_nibble(0x03);
+  lcd_write_nibble(hlcd, 0x03);
   delay_us(LCD_DELAY_INIT_3);
 
-  lcd_write_nibble(0x03);
+  lcd_write_nibble(hlcd, 0x03);
   delay_us(LCD_DELAY_INIT_3);
 
-  lcd_write_nibble(0x02);
+  lcd_write_nibble(hlcd, 0x02);
   delay_us(LCD_DELAY_INIT_3);
 
-  // Function set: 4-bit mode, 2 lines, 5x8 font
-  lcd_instruction(GDM1602A_INS_FUNCTION_SET | GDM1602A_FS_4BIT |
-                  GDM1602A_FS_2LINE | GDM1602A_FS_5x8FONT);
+  // Function set: 4-bit mode, 1 or 2 lines, 5x8 font
+  lcd_instruction(hlcd, GDM1602A_INS_FUNCTION_SET | GDM1602A_FS_4BIT | lines |
+                            GDM1602A_FS_5x8FONT);
 #endif
 
   // Display control: display off, cursor off, blink off
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | GDM1602A_DC_DISPLAY_OFF |
-                  GDM1602A_DC_CURSOR_OFF | GDM1602A_DC_BLINK_OFF);
+  lcd_instruction(hlcd, GDM1602A_INS_DISPLAY_CTRL | GDM1602A_DC_DISPLAY_OFF |
+                            GDM1602A_DC_CURSOR_OFF | GDM1602A_DC_BLINK_OFF);
 
-  gdm1602a_clear();
+  gdm1602a_clear(hlcd);
 
   // Entry mode: increment cursor, no shift
-  lcd_instruction(GDM1602A_INS_ENTRY_MODE | GDM1602A_EM_INCREMENT |
-                  GDM1602A_EM_SHIFT_OFF);
+  lcd_instruction(hlcd, GDM1602A_INS_ENTRY_MODE | GDM1602A_EM_INCREMENT |
+                            GDM1602A_EM_SHIFT_OFF);
 
-  display_control =
+  hlcd->display_control =
       GDM1602A_DC_DISPLAY_ON | GDM1602A_DC_CURSOR_OFF | GDM1602A_DC_BLINK_OFF;
 
   // Display control: display on, cursor off, blink off
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | GDM1602A_DC_DISPLAY_ON |
-                  GDM1602A_DC_CURSOR_OFF | GDM1602A_DC_BLINK_OFF);
+  lcd_instruction(hlcd, GDM1602A_INS_DISPLAY_CTRL | GDM1602A_DC_DISPLAY_ON |
+                            GDM1602A_DC_CURSOR_OFF | GDM1602A_DC_BLINK_OFF);
+}
+
+HAL_StatusTypeDef gdm1602a_clear(GDM1602A_HandleTypeDef *hlcd) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  lcd_instruction(hlcd, GDM1602A_INS_CLEAR);
+  hlcd->address = GDM1602A_LINE1_START;
+
+  memset(hlcd->framebuffer, ' ', sizeof(hlcd->framebuffer));
+  memset(hlcd->shadow, ' ', sizeof(hlcd->shadow));
+
+  return HAL_OK;
 }
 
-void gdm1602a_clear(void) { lcd_instruction(GDM1602A_INS_CLEAR); }
+HAL_StatusTypeDef gdm1602a_home(GDM1602A_HandleTypeDef *hlcd) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  lcd_instruction(hlcd, GDM1602A_INS_HOME);
+  hlcd->address = GDM1602A_LINE1_START;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef gdm1602a_set_cursor(GDM1602A_HandleTypeDef *hlcd,
+                                      uint8_t row, uint8_t col) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  if (row >= hlcd->rows) {
+    row = hlcd->rows - 1;
+  }
+
+  if (col >= hlcd->cols) {
+    col = hlcd->cols - 1;
+  }
 
-void gdm1602a_home(void) { lcd_instruction(GDM1602A_INS_HOME); }
+  lcd_set_address(hlcd, hlcd->row_offset[row] + col);
 
-void gdm1602a_set_cursor(uint8_t row, uint8_t col) {
-  uint8_t address;
+  return HAL_OK;
+}
 
-  if (row >= GDM1602A_ROWS) {
-    row = GDM1602A_ROWS - 1;
+#if LCD_USE_RW_PIN
+/* Read one visible row back from DDRAM, buffer needs hlcd->cols bytes */
+bool gdm1602a_read_row(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                       char *buffer) {
+  uint8_t address = hlcd->address;
+
+  if (row >= hlcd->rows || lcd_bus_busy()) {
+    return false;
   }
 
-  if (col >= GDM1602A_COLS) {
-    col = GDM1602A_COLS - 1;
+  lcd_set_address(hlcd, hlcd->row_offset[row]);
+
+  for (uint8_t col = 0; col < hlcd->cols; col++) {
+    // Each read advances the address counter like a write
+    buffer[col] = (char)lcd_read_byte(hlcd, 1);
+    lcd_wait(hlcd, LCD_DELAY_INS);
   }
 
-  address =
-      (row == 0) ? (GDM1602A_LINE1_START + col) : (GDM1602A_LINE2_START + col);
+  if (address != LCD_ADDRESS_UNKNOWN) {
+    lcd_set_address(hlcd, address);
+  }
 
-  lcd_instruction(GDM1602A_INS_SET_DDRAM_ADDR | address);
+  return true;
 }
+#endif
+
+/* Direct writes go to both buffers so a later flush does not undo them */
+HAL_StatusTypeDef gdm1602a_putchar(GDM1602A_HandleTypeDef *hlcd, char c) {
+  uint8_t cell;
+
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  lcd_write_data(hlcd, (uint8_t)c);
 
-void gdm1602a_putchar(char c) { lcd_write_data((uint8_t)c); }
+  if (lcd_address_to_cell(hlcd, hlcd->address, &cell)) {
+    hlcd->framebuffer[cell] = c;
+    hlcd->shadow[cell] = c;
+  }
 
-void gdm1602a_puts(const char *str) {
+  hlcd->address = lcd_address_next(hlcd, hlcd->address, true);
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef gdm1602a_puts(GDM1602A_HandleTypeDef *hlcd,
+                                const char *str) {
   while (*str) {
-    gdm1602a_putchar(*str++);
+    if (gdm1602a_putchar(hlcd, *str++) != HAL_OK) {
+      return HAL_BUSY;
+    }
+  }
+
+  return HAL_OK;
+}
+
+/* Digits of value, with a '.' before the last fraction digits */
+static uint8_t lcd_format_number(char *buffer, uint32_t value, uint8_t base,
+                                 bool upper, uint8_t fraction) {
+  char reversed[10];
+  uint8_t count = 0;
+  uint8_t length = 0;
+
+  do {
+    uint8_t digit = value % base;
+
+    if (digit < 10) {
+      reversed[count++] = '0' + digit;
+    } else {
+      reversed[count++] = (upper ? 'A' : 'a') + digit - 10;
+    }
+    value /= base;
+  } while (value || count <= fraction);
+
+  while (count > 0) {
+    buffer[length++] = reversed[--count];
+
+    if (fraction && count == fraction) {
+      buffer[length++] = '.';
+    }
   }
+
+  return length;
 }
 
-/* Printf style function */
-void gdm1602a_printf(uint8_t row, uint8_t col, const char *format, ...) {
-  char buffer[GDM1602A_COLS + 1];
+/* Minimal vsnprintf replacement writing at most size characters, no NUL.
+ * Supports %d %i %u %x %X %c %s %% with '-' and '0' flags and width, a NULL
+ * %s prints (null). %.Nf takes an integer scaled by 10^N (N <= 9), e.g.
+ * ("%.2f", 2345) prints 23.45. The 'l' length modifier is accepted, long is
+ * 32 bits on the target */
+static uint8_t lcd_format(char *out, uint8_t size, const char *format,
+                          va_list args) {
+  uint8_t length = 0;
+
+  while (*format && length < size) {
+    char digits[11];
+    const char *text = digits;
+    uint8_t text_length = 0;
+    bool negative = false;
+    bool left = false;
+    char pad = ' ';
+    uint8_t width = 0;
+    uint8_t precision = 0;
+    int32_t value;
+
+    if (*format != '%') {
+      out[length++] = *format++;
+      continue;
+    }
+    format++;
+
+    while (*format == '-' || *format == '0') {
+      if (*format == '-') {
+        left = true;
+      } else {
+        pad = '0';
+      }
+      format++;
+    }
+
+    while (*format >= '0' && *format <= '9') {
+      width = width * 10 + (*format++ - '0');
+    }
+
+    if (*format == '.') {
+      format++;
+      while (*format >= '0' && *format <= '9') {
+        precision = precision * 10 + (*format++ - '0');
+      }
+      if (precision > 9) {
+        precision = 9;
+      }
+    }
+
+    if (*format == 'l') {
+      format++;
+    }
+
+    switch (*format) {
+    case 'd':
+    case 'i':
+    case 'f':
+      value = va_arg(args, int32_t);
+      negative = value < 0;
+      text_length = lcd_format_number(
+          digits, negative ? -(uint32_t)value : (uint32_t)value, 10, false,
+          (*format == 'f') ? precision : 0);
+      break;
+    case 'u':
+      text_length =
+          lcd_format_number(digits, va_arg(args, uint32_t), 10, false, 0);
+      break;
+    case 'x':
+    case 'X':
+      text_length = lcd_format_number(digits, va_arg(args, uint32_t), 16,
+                                      *format == 'X', 0);
+      break;
+    case 'c':
+      digits[0] = (char)va_arg(args, int);
+      text_length = 1;
+      break;
+    case 's':
+      text = va_arg(args, const char *);
+      if (text == NULL) {
+        text = "(null)";
+      }
+      text_length = strnlen(text, size);
+      break;
+    case '\0':
+      return length;
+    default: // %% and unknown conversions print the character itself
+      digits[0] = *format;
+      text_length = 1;
+      break;
+    }
+    format++;
+
+    // Zero padding goes after the sign, space padding before it
+    if (negative && pad == '0' && length < size) {
+      out[length++] = '-';
+    }
+    while (!left && width > text_length + negative && length < size) {
+      out[length++] = pad;
+      width--;
+    }
+    if (negative && pad != '0' && length < size) {
+      out[length++] = '-';
+    }
+    for (uint8_t i = 0; i < text_length && length < size; i++) {
+      out[length++] = text[i];
+    }
+    while (left && width > text_length + negative && length < size) {
+      out[length++] = ' ';
+      width--;
+    }
+  }
+
+  return length;
+}
+
+/* Printf style function, formats into the framebuffer and flushes it */
+HAL_StatusTypeDef gdm1602a_printf(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                                  uint8_t col, const char *format, ...) {
   va_list args;
 
+  if (row >= hlcd->rows) {
+    row = hlcd->rows - 1;
+  }
+
+  if (col >= hlcd->cols) {
+    col = hlcd->cols - 1;
+  }
+
   va_start(args, format);
-  vsnprintf(buffer, sizeof(buffer), format, args);
+  lcd_format(&hlcd->framebuffer[row * hlcd->cols + col], hlcd->cols - col,
+             format, args);
   va_end(args);
 
-  gdm1602a_set_cursor(row, col);
-  gdm1602a_puts(buffer);
+  return gdm1602a_fb_flush(hlcd);
+}
+
+/* Framebuffer functions */
+void gdm1602a_fb_write(GDM1602A_HandleTypeDef *hlcd, uint8_t row, uint8_t col,
+                       const char *str) {
+  char *cell;
+
+  if (row >= hlcd->rows) {
+    return;
+  }
+
+  cell = &hlcd->framebuffer[row * hlcd->cols];
+  while (*str && col < hlcd->cols) {
+    cell[col++] = *str++;
+  }
+}
+
+/* Single cell, also for CGRAM codes 0-7 which can not be part of a string.
+ * Codes 8-15 show the same slots */
+void gdm1602a_fb_set(GDM1602A_HandleTypeDef *hlcd, uint8_t row, uint8_t col,
+                     char c) {
+  if (row < hlcd->rows && col < hlcd->cols) {
+    hlcd->framebuffer[row * hlcd->cols + col] = c;
+  }
+}
+
+typedef void (*lcd_emit_t)(GDM1602A_HandleTypeDef *hlcd, uint8_t data,
+                           uint8_t rs);
+
+/* Load the cached glyphs of the slots in mask into CGRAM, then return the
+ * address counter to DDRAM at address */
+static void lcd_glyphs_emit(GDM1602A_HandleTypeDef *hlcd, uint8_t mask,
+                            uint8_t address, lcd_emit_t emit) {
+  for (uint8_t slot = 0; slot < GDM1602A_CGRAM_SLOTS; slot++) {
+    if (!(mask & (1 << slot))) {
+      continue;
+    }
+
+    emit(hlcd, GDM1602A_INS_SET_CGRAM_ADDR | (slot << 3), 0);
+    for (uint8_t i = 0; i < GDM1602A_GLYPH_ROWS; i++) {
+      emit(hlcd, hlcd->glyph[slot][i], 1);
+    }
+  }
+
+  if (address != LCD_ADDRESS_UNKNOWN) {
+    emit(hlcd, GDM1602A_INS_SET_DDRAM_ADDR | address, 0);
+  }
+}
+
+/* Walk the cells of frame that differ from the LCD, one address set per run.
+ * Starts with the address counter at address and returns where it ends */
+static uint8_t lcd_fb_diff(GDM1602A_HandleTypeDef *hlcd, const char *frame,
+                           uint8_t address, lcd_emit_t emit) {
+  uint8_t cell = 0;
+
+  for (uint8_t row = 0; row < hlcd->rows; row++) {
+    uint8_t cell_address = hlcd->row_offset[row];
+
+    for (uint8_t col = 0; col < hlcd->cols; col++, cell++, cell_address++) {
+      if (frame[cell] == hlcd->shadow[cell]) {
+        continue;
+      }
+
+      if (address != cell_address) {
+        address = cell_address;
+        emit(hlcd, GDM1602A_INS_SET_DDRAM_ADDR | address, 0);
+      }
+
+      emit(hlcd, (uint8_t)frame[cell], 1);
+      address = lcd_address_next(hlcd, address, true);
+    }
+  }
+
+  return address;
+}
+
+static void lcd_emit_direct(GDM1602A_HandleTypeDef *hlcd, uint8_t data,
+                            uint8_t rs) {
+  if (rs) {
+    lcd_write_data(hlcd, data);
+  } else {
+    lcd_instruction(hlcd, data);
+  }
+}
+
+/* Send only the cells that differ from the LCD, after glyphs cached while a
+ * background refresh was running */
+HAL_StatusTypeDef gdm1602a_fb_flush(GDM1602A_HandleTypeDef *hlcd) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  if (hlcd->glyph_pending) {
+    lcd_glyphs_emit(hlcd, hlcd->glyph_pending, hlcd->address,
+                    lcd_emit_direct);
+    hlcd->glyph_pending = 0;
+  }
+
+  hlcd->address =
+      lcd_fb_diff(hlcd, hlcd->framebuffer, hlcd->address, lcd_emit_direct);
+  memcpy(hlcd->shadow, hlcd->framebuffer, hlcd->rows * hlcd->cols);
+
+  return HAL_OK;
+}
+
+#if LCD_USE_DMA_REFRESH
+/* Queue one byte as BSRR words: setup, E high, E low per bus cycle */
+static void lcd_emit_dma(GDM1602A_HandleTypeDef *hlcd, uint8_t data,
+                         uint8_t rs) {
+  uint32_t rs_bits =
+      rs ? hlcd->pins.rs.pin : ((uint32_t)hlcd->pins.rs.pin << 16);
+  uint32_t e_high = hlcd->pins.e.pin;
+  uint32_t e_low = (uint32_t)hlcd->pins.e.pin << 16;
+
+#if LCD_USE_8BIT_MODE
+  lcd_dma_words[lcd_dma_length++] = rs_bits | e_low |
+                                    hlcd->bsrr_low[data & 0x0F] |
+                                    hlcd->bsrr_high[data >> 4];
+  lcd_dma_words[lcd_dma_length++] = e_high;
+  lcd_dma_words[lcd_dma_length++] = e_low;
+#else
+  lcd_dma_words[lcd_dma_length++] =
+      rs_bits | e_low | hlcd->bsrr_high[data >> 4];
+  lcd_dma_words[lcd_dma_length++] = e_high;
+  lcd_dma_words[lcd_dma_length++] = e_low;
+  lcd_dma_words[lcd_dma_length++] =
+      rs_bits | e_low | hlcd->bsrr_high[data & 0x0F];
+  lcd_dma_words[lcd_dma_length++] = e_high;
+  lcd_dma_words[lcd_dma_length++] = e_low;
+#endif
+
+  // Empty BSRR writes while the instruction executes
+  for (uint8_t i = 0; i < LCD_DMA_IDLE_WORDS; i++) {
+    lcd_dma_words[lcd_dma_length++] = 0;
+  }
+}
+
+static void lcd_dma_xfer_cplt(DMA_HandleTypeDef *hdma) {
+  GDM1602A_HandleTypeDef *hlcd = lcd_dma_owner;
+  (void)hdma;
+
+  TIM6->CR1 &= ~TIM_CR1_CEN;
+
+  // The LCD now holds what was queued, later framebuffer changes stay dirty
+  memcpy(hlcd->shadow, lcd_dma_frame, hlcd->rows * hlcd->cols);
+  hlcd->address = lcd_dma_address;
+
+  // A glyph recached with another bitmap meanwhile must load again
+  for (uint8_t slot = 0; slot < GDM1602A_CGRAM_SLOTS; slot++) {
+    if ((lcd_dma_glyphs & (1 << slot)) &&
+        memcmp(hlcd->glyph[slot], lcd_dma_glyph[slot],
+               GDM1602A_GLYPH_ROWS) == 0) {
+      hlcd->glyph_pending &= ~(1 << slot);
+    }
+  }
+
+  lcd_dma_busy = false;
+
+  gdm1602a_refresh_cplt_callback(hlcd);
+}
+
+/* Part of the refresh may be on the LCD, its cells are still dirty but the
+ * address counter is unknown */
+static void lcd_dma_xfer_error(DMA_HandleTypeDef *hdma) {
+  (void)hdma;
+
+  TIM6->CR1 &= ~TIM_CR1_CEN;
+  lcd_dma_owner->address = LCD_ADDRESS_UNKNOWN;
+  lcd_dma_busy = false;
+}
+
+/* Timer and DMA setup for the background refresh */
+bool gdm1602a_refresh_init(void) {
+  uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+
+  // APB1 timers run at twice PCLK1 when the APB1 prescaler is not 1
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+    timer_clock *= 2;
+  }
+
+  // TIM6 update event every LCD_DMA_TICK_US, one DMA request per update
+  __HAL_RCC_TIM6_CLK_ENABLE();
+  TIM6->CR1 = 0;
+  TIM6->PSC = timer_clock / 1000000 - 1;
+  TIM6->ARR = LCD_DMA_TICK_US - 1;
+  TIM6->EGR = TIM_EGR_UG;
+  TIM6->SR = 0;
+  TIM6->DIER = TIM_DIER_UDE;
+
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  hdma_lcd.Instance = DMA1_Channel3;
+  hdma_lcd.Init.Request = DMA_REQUEST_6; // TIM6_UP
+  hdma_lcd.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_lcd.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_lcd.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_lcd.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_lcd.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma_lcd.Init.Mode = DMA_NORMAL;
+  hdma_lcd.Init.Priority = DMA_PRIORITY_LOW;
+  if (HAL_DMA_Init(&hdma_lcd) != HAL_OK) {
+    return false;
+  }
+  hdma_lcd.XferCpltCallback = lcd_dma_xfer_cplt;
+  hdma_lcd.XferErrorCallback = lcd_dma_xfer_error;
+
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+
+  return true;
+}
+
+/* Same diff as gdm1602a_fb_flush, clocked out by TIM6 and DMA */
+bool gdm1602a_fb_flush_async(GDM1602A_HandleTypeDef *hlcd) {
+  GPIO_TypeDef *port = hlcd->pins.db[GDM1602A_DB4].port;
+
+  // BSRR words drive RS, E and data, so all of them must share one port
+  if (lcd_dma_busy || !hlcd->same_port || hlcd->pins.rs.port != port ||
+      hlcd->pins.e.port != port) {
+    return false;
+  }
+
+  // The word buffer only holds the worst case diff of the configured geometry
+  if (hlcd->rows > LCD_DMA_MAX_ROWS || hlcd->cols > LCD_DMA_MAX_COLS) {
+    return false;
+  }
+
+  lcd_dma_owner = hlcd;
+  lcd_dma_length = 0;
+
+  lcd_dma_glyphs = hlcd->glyph_pending;
+  if (lcd_dma_glyphs) {
+    memcpy(lcd_dma_glyph, hlcd->glyph, sizeof(lcd_dma_glyph));
+    lcd_glyphs_emit(hlcd, lcd_dma_glyphs, hlcd->address, lcd_emit_dma);
+  }
+
+  // Snapshot, the framebuffer may change while the words are clocked out
+  memcpy(lcd_dma_frame, hlcd->framebuffer, hlcd->rows * hlcd->cols);
+  lcd_dma_address =
+      lcd_fb_diff(hlcd, lcd_dma_frame, hlcd->address, lcd_emit_dma);
+
+  if (lcd_dma_length == 0) {
+    gdm1602a_refresh_cplt_callback(hlcd);
+    return true;
+  }
+
+  lcd_dma_busy = true;
+
+  if (HAL_DMA_Start_IT(&hdma_lcd, (uint32_t)lcd_dma_words,
+                       (uint32_t)&port->BSRR, lcd_dma_length) != HAL_OK) {
+    lcd_dma_busy = false;
+    return false;
+  }
+
+  TIM6->CNT = 0;
+  TIM6->CR1 |= TIM_CR1_CEN;
+
+  return true;
+}
+
+bool gdm1602a_refresh_busy(void) { return lcd_dma_busy; }
+
+/* Called from interrupt context when the refresh has been clocked out */
+__weak void gdm1602a_refresh_cplt_callback(GDM1602A_HandleTypeDef *hlcd) {
+  (void)hlcd;
+}
+
+/* Call from DMA1_Channel3_IRQHandler */
+void gdm1602a_dma_irq_handler(void) { HAL_DMA_IRQHandler(&hdma_lcd); }
+#endif
+
+static HAL_StatusTypeDef lcd_display_control(GDM1602A_HandleTypeDef *hlcd,
+                                             uint8_t display_control) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  hlcd->display_control = display_control;
+  lcd_instruction(hlcd, GDM1602A_INS_DISPLAY_CTRL | hlcd->display_control);
+
+  return HAL_OK;
+}
+
+static HAL_StatusTypeDef lcd_shift(GDM1602A_HandleTypeDef *hlcd,
+                                   uint8_t direction) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  lcd_instruction(hlcd, GDM1602A_INS_CURSOR_SHIFT | direction);
+
+  if (direction == GDM1602A_CS_CURSOR_L) {
+    hlcd->address = lcd_address_next(hlcd, hlcd->address, false);
+  } else if (direction == GDM1602A_CS_CURSOR_R) {
+    hlcd->address = lcd_address_next(hlcd, hlcd->address, true);
+  }
+
+  return HAL_OK;
 }
 
 /* Display control functions */
-void gdm1602a_display_on(void) {
+HAL_StatusTypeDef gdm1602a_display_on(GDM1602A_HandleTypeDef *hlcd) {
   /**
    * Scenario:
    *
@@ -293,61 +1039,156 @@ void gdm1602a_display_on(void) {
    * Will result in only bit 2 cleared
    * display_control = 0b00000000
    */
-  display_control |= GDM1602A_DC_DISPLAY_ON;
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | display_control);
+  return lcd_display_control(hlcd,
+                             hlcd->display_control | GDM1602A_DC_DISPLAY_ON);
 }
 
-void gdm1602a_display_off(void) {
-  display_control &= ~GDM1602A_DC_DISPLAY_ON;
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | display_control);
+HAL_StatusTypeDef gdm1602a_display_off(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_display_control(hlcd,
+                             hlcd->display_control & ~GDM1602A_DC_DISPLAY_ON);
 }
 
-void gdm1602a_cursor_on(void) {
-  display_control |= GDM1602A_DC_CURSOR_ON;
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | display_control);
+HAL_StatusTypeDef gdm1602a_cursor_on(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_display_control(hlcd,
+                             hlcd->display_control | GDM1602A_DC_CURSOR_ON);
 }
 
-void gdm1602a_cursor_off(void) {
-  display_control &= ~GDM1602A_DC_CURSOR_ON;
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | display_control);
+HAL_StatusTypeDef gdm1602a_cursor_off(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_display_control(hlcd,
+                             hlcd->display_control & ~GDM1602A_DC_CURSOR_ON);
 }
 
-void gdm1602a_blink_on(void) {
-  display_control |= GDM1602A_DC_BLINK_ON;
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | display_control);
+HAL_StatusTypeDef gdm1602a_blink_on(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_display_control(hlcd,
+                             hlcd->display_control | GDM1602A_DC_BLINK_ON);
 }
 
-void gdm1602a_blink_off(void) {
-  display_control &= ~GDM1602A_DC_BLINK_ON;
-  lcd_instruction(GDM1602A_INS_DISPLAY_CTRL | display_control);
+HAL_StatusTypeDef gdm1602a_blink_off(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_display_control(hlcd,
+                             hlcd->display_control & ~GDM1602A_DC_BLINK_ON);
 }
 
 /* Shift functions */
-void gdm1602a_shift_cursor_left(void) {
-  lcd_instruction(GDM1602A_INS_CURSOR_SHIFT | GDM1602A_CS_CURSOR_L);
+HAL_StatusTypeDef gdm1602a_shift_cursor_left(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_shift(hlcd, GDM1602A_CS_CURSOR_L);
 }
 
-void gdm1602a_shift_cursor_right(void) {
-  lcd_instruction(GDM1602A_INS_CURSOR_SHIFT | GDM1602A_CS_CURSOR_R);
+HAL_StatusTypeDef gdm1602a_shift_cursor_right(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_shift(hlcd, GDM1602A_CS_CURSOR_R);
 }
 
-void gdm1602a_shift_display_left(void) {
-  lcd_instruction(GDM1602A_INS_CURSOR_SHIFT | GDM1602A_CS_DISPLAY_L);
+HAL_StatusTypeDef gdm1602a_shift_display_left(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_shift(hlcd, GDM1602A_CS_DISPLAY_L);
 }
 
-void gdm1602a_shift_display_right(void) {
-  lcd_instruction(GDM1602A_INS_CURSOR_SHIFT | GDM1602A_CS_DISPLAY_R);
+HAL_StatusTypeDef gdm1602a_shift_display_right(GDM1602A_HandleTypeDef *hlcd) {
+  return lcd_shift(hlcd, GDM1602A_CS_DISPLAY_R);
+}
+
+/* FNV-1a over the 5 used bits of each bitmap row */
+static uint32_t lcd_glyph_hash(const uint8_t *bitmap) {
+  uint32_t hash = 0x811C9DC5;
+
+  for (uint8_t i = 0; i < GDM1602A_GLYPH_ROWS; i++) {
+    hash ^= bitmap[i] & 0x1F;
+    hash *= 0x01000193;
+  }
+
+  return hash;
+}
+
+/* Record a bitmap in the glyph cache and write it to CGRAM, or leave it to
+ * the next flush while a background refresh is running */
+static void lcd_load_glyph(GDM1602A_HandleTypeDef *hlcd, uint8_t location,
+                           const uint8_t *bitmap) {
+  for (uint8_t i = 0; i < GDM1602A_GLYPH_ROWS; i++) {
+    hlcd->glyph[location][i] = bitmap[i] & 0x1F;
+  }
+
+  hlcd->glyph_hash[location] = lcd_glyph_hash(bitmap);
+  hlcd->glyph_valid |= 1 << location;
+  hlcd->glyph_used[location] = ++hlcd->glyph_clock;
+
+  if (lcd_bus_busy()) {
+    hlcd->glyph_pending |= 1 << location;
+    return;
+  }
+
+  // Return to DDRAM at the previous cursor position
+  lcd_glyphs_emit(hlcd, 1 << location, hlcd->address, lcd_emit_direct);
+  hlcd->glyph_pending &= ~(1 << location);
 }
 
 /* Create custom character (8 characters limit) */
-void gdm1602a_create_char(uint8_t location, uint8_t charmap[8]) {
-  location &= 0x07;
-  lcd_instruction(GDM1602A_INS_SET_CGRAM_ADDR | (location << 3));
+HAL_StatusTypeDef gdm1602a_create_char(GDM1602A_HandleTypeDef *hlcd,
+                                       uint8_t location, uint8_t charmap[8]) {
+  if (lcd_bus_busy()) {
+    return HAL_BUSY;
+  }
+
+  lcd_load_glyph(hlcd, location & 0x07, charmap);
+
+  return HAL_OK;
+}
+
+/* Character code (0-7) showing bitmap. A slot already holding the same
+ * bitmap is reused without bus traffic, otherwise the least recently used
+ * slot is rewritten, preferring slots not shown in the framebuffer. During a
+ * background refresh the CGRAM write waits for the next flush */
+uint8_t gdm1602a_glyph(GDM1602A_HandleTypeDef *hlcd,
+                       const uint8_t bitmap[GDM1602A_GLYPH_ROWS]) {
+  uint32_t hash = lcd_glyph_hash(bitmap);
+  uint8_t visible = 0;
+  uint8_t victim = 0;
+  bool victim_visible = true;
+
+  for (uint8_t slot = 0; slot < GDM1602A_CGRAM_SLOTS; slot++) {
+    if (!(hlcd->glyph_valid & (1 << slot)) || hlcd->glyph_hash[slot] != hash) {
+      continue;
+    }
 
-  for (uint8_t i = 0; i < 8; i++) {
-    lcd_write_data(charmap[i]);
+    bool match = true;
+    for (uint8_t i = 0; i < GDM1602A_GLYPH_ROWS; i++) {
+      if (hlcd->glyph[slot][i] != (bitmap[i] & 0x1F)) {
+        match = false;
+        break;
+      }
+    }
+
+    if (match) {
+      hlcd->glyph_used[slot] = ++hlcd->glyph_clock;
+      return slot;
+    }
   }
 
-  // Return to DDRAM
-  lcd_instruction(GDM1602A_INS_SET_DDRAM_ADDR);
+  for (uint8_t cell = 0; cell < hlcd->rows * hlcd->cols; cell++) {
+    uint8_t code = (uint8_t)hlcd->framebuffer[cell];
+
+    // Codes 8-15 show the same slots as 0-7
+    if (code < 2 * GDM1602A_CGRAM_SLOTS) {
+      visible |= 1 << (code % GDM1602A_CGRAM_SLOTS);
+    }
+  }
+
+  for (uint8_t slot = 0; slot < GDM1602A_CGRAM_SLOTS; slot++) {
+    bool slot_visible = (visible & (1 << slot)) != 0;
+
+    // Free slots first, then LRU among hidden slots, then LRU overall
+    if (!(hlcd->glyph_valid & (1 << slot)) && !slot_visible) {
+      victim = slot;
+      break;
+    }
+
+    if ((victim_visible && !slot_visible) ||
+        (victim_visible == slot_visible &&
+         hlcd->glyph_clock - hlcd->glyph_used[slot] >
+             hlcd->glyph_clock - hlcd->glyph_used[victim])) {
+      victim = slot;
+      victim_visible = slot_visible;
+    }
+  }
+
+  lcd_load_glyph(hlcd, victim, bitmap);
+
+  return victim;
 }
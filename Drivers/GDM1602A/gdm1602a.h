@@ -1,6 +1,8 @@
 #ifndef GDM1602A_H
 #define GDM1602A_H
 
+#include "gdm1602a_config.h"
+#include "stm32l4xx_hal.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -64,31 +66,147 @@
 #define GDM1602A_FS_5x8FONT (0 << GDM1602A_FS_F_BIT)
 #define GDM1602A_FS_5x11FONT (1 << GDM1602A_FS_F_BIT)
 
-/* DDRAM Address Locations for 16x2 Display */
-#define GDM1602A_LINE1_START 0x00 // First line starts at 0x00
-#define GDM1602A_LINE2_START 0x40 // Second line starts at 0x40
-
-/* Display Dimensions */
-#define GDM1602A_COLS 16
-#define GDM1602A_ROWS 2
-
-void gdm1602a_init(void);
-void gdm1602a_clear(void);
-void gdm1602a_home(void);
-void gdm1602a_set_cursor(uint8_t row, uint8_t col);
-void gdm1602a_putchar(char c);
-void gdm1602a_puts(const char *str);
-void gdm1602a_printf(uint8_t row, uint8_t col, const char *format, ...);
-void gdm1602a_display_on(void);
-void gdm1602a_display_off(void);
-void gdm1602a_cursor_on(void);
-void gdm1602a_cursor_off(void);
-void gdm1602a_blink_on(void);
-void gdm1602a_blink_off(void);
-void gdm1602a_shift_cursor_left(void);
-void gdm1602a_shift_cursor_right(void);
-void gdm1602a_shift_display_left(void);
-void gdm1602a_shift_display_right(void);
-void gdm1602a_create_char(uint8_t location, uint8_t charmap[8]);
+/* Status Read */
+#define GDM1602A_BUSY_FLAG 0x80    // BF, set while an instruction is executing
+#define GDM1602A_ADDRESS_MASK 0x7F // Address counter bits
+
+/* DDRAM Address Locations */
+#define GDM1602A_LINE1_START 0x00     // First line starts at 0x00
+#define GDM1602A_LINE2_START 0x40     // Second line starts at 0x40
+#define GDM1602A_DDRAM_LINE_LENGTH 40 // Cells per line in 2-line mode
+#define GDM1602A_DDRAM_SIZE 80        // Cells in 1-line mode
+
+/* CGRAM */
+#define GDM1602A_CGRAM_SLOTS 8 // 5x8 custom characters, codes 0-7
+/* The controller ignores bit 3 of CGRAM codes, so codes 8-15 show slots 0-7
+ * again. gdm1602a_glyph returns 0-7 and treats a slot as shown when either
+ * of its codes is in the framebuffer */
+#define GDM1602A_GLYPH_ROWS 8  // Bitmap rows, low 5 bits used
+#define GDM1602A_GLYPH_COLS 5
+
+/* Character ROM */
+#define GDM1602A_CHAR_FULL 0xFF // All pixels on
+
+/* Largest supported display (20x4, 40x2) */
+#define GDM1602A_MAX_ROWS 4
+#define GDM1602A_MAX_COLS 40
+#define GDM1602A_MAX_CELLS 80
+
+/* Supported HD44780 panel geometries */
+typedef enum {
+  GDM1602A_GEOMETRY_16X1 = 0, // 1-line mode
+  GDM1602A_GEOMETRY_16X2,
+  GDM1602A_GEOMETRY_16X4, // Rows at 0x00, 0x40, 0x10, 0x50
+  GDM1602A_GEOMETRY_20X2,
+  GDM1602A_GEOMETRY_20X4, // Rows at 0x00, 0x40, 0x14, 0x54
+  GDM1602A_GEOMETRY_40X2,
+} GDM1602A_GeometryTypeDef;
+
+/* Data bus line indexes */
+#define GDM1602A_DB0 0
+#define GDM1602A_DB4 4
+
+typedef struct {
+  GPIO_TypeDef *port;
+  uint16_t pin;
+} GDM1602A_PinTypeDef;
+
+/* Pin map, see LCD_PIN_MAP_DEFAULT in gdm1602a_config.h */
+typedef struct {
+  GDM1602A_PinTypeDef rs;
+  GDM1602A_PinTypeDef rw; // Used only with LCD_USE_RW_PIN
+  GDM1602A_PinTypeDef e;
+  GDM1602A_PinTypeDef db[8]; // DB0-DB3 used only with LCD_USE_8BIT_MODE
+} GDM1602A_PinMapTypeDef;
+
+/* GDM1602A Handle Structure */
+typedef struct {
+  GDM1602A_PinMapTypeDef pins;
+  uint8_t display_control;
+
+  /* Geometry, row_offset holds the DDRAM address of each row's first cell */
+  uint8_t rows;
+  uint8_t cols;
+  uint8_t row_offset[GDM1602A_MAX_ROWS];
+
+  /* DDRAM address counter mirrored in software */
+  uint8_t address;
+
+  /* Desired screen content and what the LCD currently holds, row-major */
+  char framebuffer[GDM1602A_MAX_CELLS];
+  char shadow[GDM1602A_MAX_CELLS];
+
+  /* CGRAM glyph cache, see gdm1602a_glyph */
+  uint8_t glyph[GDM1602A_CGRAM_SLOTS][GDM1602A_GLYPH_ROWS];
+  uint32_t glyph_hash[GDM1602A_CGRAM_SLOTS];
+  uint32_t glyph_used[GDM1602A_CGRAM_SLOTS]; // LRU stamps
+  uint32_t glyph_clock; // Ages are clock - stamp, safe across wrap-around
+  uint8_t glyph_valid;   // Bit per slot holding a known bitmap
+  uint8_t glyph_pending; // Bit per slot cached but not yet written to CGRAM
+
+#if LCD_USE_BUS_STATS
+  uint32_t bus_cycles; // CPU cycles spent in bus transfers and waits
+#endif
+
+#if LCD_DATA_PINS_SAME_PORT
+  /* Nibble to BSRR value, built from the pin map in gdm1602a_init */
+  uint32_t bsrr_low[16];
+  uint32_t bsrr_high[16];
+  bool same_port; // Checked in gdm1602a_init, else pin by pin writes
+#endif
+} GDM1602A_HandleTypeDef;
+
+/* Functions that access the bus return HAL_BUSY and leave the handle
+ * unchanged while a background refresh (gdm1602a_fb_flush_async) is running.
+ * gdm1602a_init must not be called during a refresh */
+void gdm1602a_init(GDM1602A_HandleTypeDef *hlcd,
+                   const GDM1602A_PinMapTypeDef *pins,
+                   GDM1602A_GeometryTypeDef geometry);
+HAL_StatusTypeDef gdm1602a_clear(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_home(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_set_cursor(GDM1602A_HandleTypeDef *hlcd,
+                                      uint8_t row, uint8_t col);
+#if LCD_USE_RW_PIN
+bool gdm1602a_read_row(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                       char *buffer);
+#endif
+HAL_StatusTypeDef gdm1602a_putchar(GDM1602A_HandleTypeDef *hlcd, char c);
+HAL_StatusTypeDef gdm1602a_puts(GDM1602A_HandleTypeDef *hlcd,
+                                const char *str);
+/* gdm1602a_printf has its own formatter: %d %i %u %x %X %c %s %% with '-' and
+ * '0' flags and width. %.Nf is fixed point, it reads an int32_t scaled by
+ * 10^N, e.g. ("%.2f", 2345) prints 23.45. Passing a float or double is
+ * undefined behaviour and no compiler format check catches it */
+HAL_StatusTypeDef gdm1602a_printf(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                                  uint8_t col, const char *format, ...);
+void gdm1602a_fb_write(GDM1602A_HandleTypeDef *hlcd, uint8_t row, uint8_t col,
+                       const char *str);
+void gdm1602a_fb_set(GDM1602A_HandleTypeDef *hlcd, uint8_t row, uint8_t col,
+                     char c);
+HAL_StatusTypeDef gdm1602a_fb_flush(GDM1602A_HandleTypeDef *hlcd);
+/* The background refresh has one TIM6/DMA channel and one static word buffer
+ * sized for LCD_DMA_MAX_ROWS x LCD_DMA_MAX_COLS. It serves one display at a
+ * time, gdm1602a_fb_flush_async returns false for a larger geometry or while a
+ * refresh runs, and all displays refuse synchronous bus access with HAL_BUSY
+ * until it completes */
+bool gdm1602a_refresh_init(void);
+bool gdm1602a_fb_flush_async(GDM1602A_HandleTypeDef *hlcd);
+bool gdm1602a_refresh_busy(void);
+void gdm1602a_refresh_cplt_callback(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_dma_irq_handler(void);
+HAL_StatusTypeDef gdm1602a_display_on(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_display_off(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_cursor_on(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_cursor_off(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_blink_on(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_blink_off(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_shift_cursor_left(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_shift_cursor_right(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_shift_display_left(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_shift_display_right(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_create_char(GDM1602A_HandleTypeDef *hlcd,
+                                       uint8_t location, uint8_t charmap[8]);
+uint8_t gdm1602a_glyph(GDM1602A_HandleTypeDef *hlcd,
+                       const uint8_t bitmap[GDM1602A_GLYPH_ROWS]);
 
 #endif
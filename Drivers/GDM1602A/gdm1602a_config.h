@@ -3,10 +3,31 @@
 
 #include "main.h"
 
-/* Configuration options */
+/* Configuration options, can be overridden from the build */
+#ifndef LCD_USE_RW_PIN
 #define LCD_USE_RW_PIN 0
+#endif
+#ifndef LCD_USE_BUSY_FLAG
 #define LCD_USE_BUSY_FLAG 0
+#endif
+#ifndef LCD_USE_8BIT_MODE
 #define LCD_USE_8BIT_MODE 0
+#endif
+#ifndef LCD_DATA_PINS_SAME_PORT
+#define LCD_DATA_PINS_SAME_PORT 0 // Data pins share one port, checked at init
+#endif
+#ifndef LCD_USE_DMA_REFRESH
+#define LCD_USE_DMA_REFRESH 0 // TIM6 + DMA1 channel 3 background flush
+#endif
+#ifndef LCD_DMA_MAX_ROWS
+#define LCD_DMA_MAX_ROWS 2 // Largest geometry of the DMA refreshed display,
+#endif                     // sizes its static word buffer
+#ifndef LCD_DMA_MAX_COLS
+#define LCD_DMA_MAX_COLS 16
+#endif
+#ifndef LCD_USE_BUS_STATS
+#define LCD_USE_BUS_STATS 0 // DWT cycles in hlcd->bus_cycles
+#endif
 
 /* Data pins */
 #if LCD_USE_8BIT_MODE
@@ -33,6 +54,43 @@
 #define LCD_RS_PORT LCD_RS_GPIO_Port
 #define LCD_E_PIN LCD_E_Pin
 #define LCD_E_PORT LCD_E_GPIO_Port
+#if LCD_USE_RW_PIN
+#define LCD_RW_PIN LCD_RW_Pin
+#define LCD_RW_PORT LCD_RW_GPIO_Port
+#endif
+
+/**
+ * Pin map built from the pins above, e.g.
+ * static const GDM1602A_PinMapTypeDef lcd_pins = LCD_PIN_MAP_DEFAULT;
+ * Further displays need their own GDM1602A_PinMapTypeDef
+ */
+#if LCD_USE_RW_PIN
+#define LCD_PIN_MAP_RW .rw = {LCD_RW_PORT, LCD_RW_PIN},
+#else
+#define LCD_PIN_MAP_RW
+#endif
+#if LCD_USE_8BIT_MODE
+#define LCD_PIN_MAP_DB_LOW                                                     \
+  [0] = {LCD_DB0_PORT, LCD_DB0_PIN}, [1] = {LCD_DB1_PORT, LCD_DB1_PIN},        \
+  [2] = {LCD_DB2_PORT, LCD_DB2_PIN}, [3] = {LCD_DB3_PORT, LCD_DB3_PIN},
+#else
+#define LCD_PIN_MAP_DB_LOW
+#endif
+#define LCD_PIN_MAP_DEFAULT                                                    \
+  {.rs = {LCD_RS_PORT, LCD_RS_PIN},                                            \
+   .e = {LCD_E_PORT, LCD_E_PIN},                                               \
+   LCD_PIN_MAP_RW.db = {LCD_PIN_MAP_DB_LOW[4] = {LCD_DB4_PORT, LCD_DB4_PIN},   \
+                        [5] = {LCD_DB5_PORT, LCD_DB5_PIN},                     \
+                        [6] = {LCD_DB6_PORT, LCD_DB6_PIN},                     \
+                        [7] = {LCD_DB7_PORT, LCD_DB7_PIN}}}
+
+#if LCD_USE_BUSY_FLAG && !LCD_USE_RW_PIN
+#error "LCD_USE_BUSY_FLAG requires LCD_USE_RW_PIN"
+#endif
+
+#if LCD_USE_DMA_REFRESH && !LCD_DATA_PINS_SAME_PORT
+#error "LCD_USE_DMA_REFRESH requires LCD_DATA_PINS_SAME_PORT"
+#endif
 
 /* Timing [us] */
 #define LCD_DELAY_INIT_1 15000
@@ -41,5 +99,11 @@
 #define LCD_DELAY_INS_CLEAR_HOME 2000
 #define LCD_DELAY_INS 50
 #define LCD_DELAY_ENABLE 1
+#define LCD_BUSY_TIMEOUT 2000 // Busy flag polls before fixed delay fallback
+
+/* DMA refresh timing, one BSRR word per tick */
+#define LCD_DMA_TICK_US 10
+#define LCD_DMA_IDLE_WORDS                                                     \
+  ((LCD_DELAY_INS + LCD_DMA_TICK_US - 1) / LCD_DMA_TICK_US - 1)
 
 #endif
@@ -11,6 +11,19 @@ static const char *test_names[] = {
 
 #define NUM_TESTS (sizeof(test_names) / sizeof(test_names[0]))
 
+/* Screen each test leaves behind, TEST_COLS characters per row without
+ * terminator. Test 6 shows CGRAM characters 0-5 */
+static const char test_expected[][TEST_ROWS][TEST_COLS] = {
+    {"Char by char... ", "                "},
+    {"Blink OFF       ", "                "},
+    {"Test 3: Display ", "Control         "},
+    {"Test 4: Move    ", "*             * "},
+    {"Scroll Left>>>> ", "1234567890ABCDEF"},
+    {"\0 \1 \2 Custom!   ", "\3 \4 \5 Chars     "},
+    {"Temp: 25 C      ", "Humid: 65%      "},
+    {"Top (home)      ", "          Bottom"},
+    {"Scrolling:      ", "!               "}};
+
 /**
  * @brief Get the number of available tests
  * @return Number of tests
@@ -29,42 +42,57 @@ const char *gdm1602a_test_get_name(uint8_t test_number) {
   return test_names[test_number];
 }
 
+/**
+ * @brief Get the screen a test leaves behind
+ * @param test_number Test index (0-based)
+ * @param row Display row
+ * @return TEST_COLS characters, not NUL terminated, or NULL if out of range
+ */
+const char *gdm1602a_test_get_expected(uint8_t test_number, uint8_t row) {
+  if (test_number >= NUM_TESTS || row >= TEST_ROWS) {
+    return NULL;
+  }
+  return test_expected[test_number][row];
+}
+
 /**
  * @brief Run a single test by number
+ * @param hlcd Pointer to GDM1602A handle structure
  * @param test_number Test index (0-based)
  */
-void gdm1602a_test_run_single(uint8_t test_number) {
+void gdm1602a_test_run_single(GDM1602A_HandleTypeDef *hlcd,
+                              uint8_t test_number) {
   switch (test_number) {
   case 0:
-    gdm1602a_test_basic_output();
+    gdm1602a_test_basic_output(hlcd);
     break;
   case 1:
-    gdm1602a_test_cursor_control();
+    gdm1602a_test_cursor_control(hlcd);
     break;
   case 2:
-    gdm1602a_test_display_control();
+    gdm1602a_test_display_control(hlcd);
     break;
   case 3:
-    gdm1602a_test_cursor_movement();
+    gdm1602a_test_cursor_movement(hlcd);
     break;
   case 4:
-    gdm1602a_test_display_shift();
+    gdm1602a_test_display_shift(hlcd);
     break;
   case 5:
-    gdm1602a_test_custom_characters();
+    gdm1602a_test_custom_characters(hlcd);
     break;
   case 6:
-    gdm1602a_test_printf_function();
+    gdm1602a_test_printf_function(hlcd);
     break;
   case 7:
-    gdm1602a_test_multiline_text();
+    gdm1602a_test_multiline_text(hlcd);
     break;
   case 8:
-    gdm1602a_test_scrolling_text();
+    gdm1602a_test_scrolling_text(hlcd);
     break;
   default:
-    gdm1602a_clear();
-    gdm1602a_printf(0, 0, "Invalid test #%d", test_number);
+    gdm1602a_clear(hlcd);
+    gdm1602a_printf(hlcd, 0, 0, "Invalid test #%d", test_number);
     HAL_Delay(TEST_DELAY_MEDIUM);
     break;
   }
@@ -72,45 +100,121 @@ void gdm1602a_test_run_single(uint8_t test_number) {
 
 /**
  * @brief Run all tests in sequence
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_all(void) {
+void gdm1602a_test_all(GDM1602A_HandleTypeDef *hlcd) {
   // Welcome message
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "GDM1602A Tests");
-  gdm1602a_printf(1, 0, "Starting...");
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "GDM1602A Tests");
+  gdm1602a_printf(hlcd, 1, 0, "Starting...");
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Run all tests
   for (uint8_t i = 0; i < NUM_TESTS; i++) {
-    gdm1602a_test_run_single(i);
+#if LCD_USE_BUS_STATS
+    hlcd->bus_cycles = 0;
+#endif
+    gdm1602a_test_run_single(hlcd, i);
     HAL_Delay(TEST_DELAY_LONG);
+    gdm1602a_test_report(hlcd, i);
   }
 
   // All tests complete
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "All tests");
-  gdm1602a_printf(1, 0, "completed!");
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "All tests");
+  gdm1602a_printf(hlcd, 1, 0, "completed!");
   HAL_Delay(TEST_DELAY_LONG);
 }
 
+/**
+ * @brief Show the outcome of a finished test
+ * @param hlcd Pointer to GDM1602A handle structure
+ * @param test_number Test index (0-based)
+ * @note Only has something to report with LCD_USE_RW_PIN or LCD_USE_BUS_STATS
+ */
+void gdm1602a_test_report(GDM1602A_HandleTypeDef *hlcd, uint8_t test_number) {
+#if LCD_USE_RW_PIN || LCD_USE_BUS_STATS
+#if LCD_USE_RW_PIN
+  // Read back before the report overwrites the screen
+  bool passed = gdm1602a_test_verify(hlcd, test_number);
+#endif
+
+  gdm1602a_clear(hlcd);
+#if LCD_USE_RW_PIN
+  gdm1602a_printf(hlcd, 0, 0, "Test %u %s", test_number + 1,
+                  passed ? "PASS" : "FAIL");
+#else
+  gdm1602a_printf(hlcd, 0, 0, "Test %u", test_number + 1);
+#endif
+#if LCD_USE_BUS_STATS
+  // Cycles to microseconds at the current core clock
+  gdm1602a_printf(hlcd, 1, 0, "Bus: %lu us",
+                  hlcd->bus_cycles / (SystemCoreClock / 1000000));
+#endif
+  HAL_Delay(TEST_DELAY_MEDIUM);
+#else
+  (void)hlcd;
+  (void)test_number;
+#endif
+}
+
+#if LCD_USE_RW_PIN
+/**
+ * @brief Compare DDRAM with the screen a test should leave behind
+ * @param hlcd Pointer to GDM1602A handle structure
+ * @param test_number Test index (0-based)
+ * @return true if the display holds the expected characters
+ * @note Columns past TEST_COLS must hold spaces
+ */
+bool gdm1602a_test_verify(GDM1602A_HandleTypeDef *hlcd, uint8_t test_number) {
+  char row_data[GDM1602A_MAX_COLS];
+
+  if (test_number >= NUM_TESTS || hlcd->rows < TEST_ROWS ||
+      hlcd->cols < TEST_COLS) {
+    return false;
+  }
+
+  for (uint8_t row = 0; row < hlcd->rows; row++) {
+    if (!gdm1602a_read_row(hlcd, row, row_data)) {
+      return false;
+    }
+
+    for (uint8_t col = 0; col < hlcd->cols; col++) {
+      char expected = ' ';
+
+      if (row < TEST_ROWS && col < TEST_COLS) {
+        expected = test_expected[test_number][row][col];
+      }
+
+      if (row_data[col] != expected) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+#endif
+
 /**
  * @brief Test 1: Basic text output
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_basic_output(void) {
-  gdm1602a_clear();
-  gdm1602a_puts("Test 1: Output");
+void gdm1602a_test_basic_output(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_puts(hlcd, "Test 1: Output");
   HAL_Delay(TEST_DELAY_SHORT);
 
-  gdm1602a_set_cursor(1, 0);
-  gdm1602a_puts("Hello, World!");
+  gdm1602a_set_cursor(hlcd, 1, 0);
+  gdm1602a_puts(hlcd, "Hello, World!");
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Test character by character
-  gdm1602a_clear();
-  gdm1602a_set_cursor(0, 0);
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 0, 0);
   const char *msg = "Char by char...";
   for (int i = 0; msg[i] != '\0'; i++) {
-    gdm1602a_putchar(msg[i]);
+    gdm1602a_putchar(hlcd, msg[i]);
     HAL_Delay(100);
   }
   HAL_Delay(TEST_DELAY_SHORT);
@@ -118,58 +222,60 @@ void gdm1602a_test_basic_output(void) {
 
 /**
  * @brief Test 2: Cursor control (on/off/blink)
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_cursor_control(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 2: Cursor");
+void gdm1602a_test_cursor_control(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 2: Cursor");
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Cursor ON
-  gdm1602a_clear();
-  gdm1602a_set_cursor(0, 0);
-  gdm1602a_puts("Cursor ON");
-  gdm1602a_set_cursor(1, 0);
-  gdm1602a_cursor_on();
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 0, 0);
+  gdm1602a_puts(hlcd, "Cursor ON");
+  gdm1602a_set_cursor(hlcd, 1, 0);
+  gdm1602a_cursor_on(hlcd);
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Cursor OFF
-  gdm1602a_clear();
-  gdm1602a_puts("Cursor OFF");
-  gdm1602a_cursor_off();
+  gdm1602a_clear(hlcd);
+  gdm1602a_puts(hlcd, "Cursor OFF");
+  gdm1602a_cursor_off(hlcd);
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Blinking cursor
-  gdm1602a_clear();
-  gdm1602a_set_cursor(0, 0);
-  gdm1602a_puts("Blink ON");
-  gdm1602a_set_cursor(1, 0);
-  gdm1602a_cursor_on();
-  gdm1602a_blink_on();
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 0, 0);
+  gdm1602a_puts(hlcd, "Blink ON");
+  gdm1602a_set_cursor(hlcd, 1, 0);
+  gdm1602a_cursor_on(hlcd);
+  gdm1602a_blink_on(hlcd);
   HAL_Delay(TEST_DELAY_LONG);
 
   // Blink OFF
-  gdm1602a_clear();
-  gdm1602a_puts("Blink OFF");
-  gdm1602a_blink_off();
+  gdm1602a_clear(hlcd);
+  gdm1602a_puts(hlcd, "Blink OFF");
+  gdm1602a_blink_off(hlcd);
   HAL_Delay(TEST_DELAY_SHORT);
-  gdm1602a_cursor_off();
+  gdm1602a_cursor_off(hlcd);
   HAL_Delay(TEST_DELAY_MEDIUM);
 }
 
 /**
  * @brief Test 3: Display on/off
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_display_control(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 3: Display");
-  gdm1602a_printf(1, 0, "Control");
+void gdm1602a_test_display_control(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 3: Display");
+  gdm1602a_printf(hlcd, 1, 0, "Control");
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Blink display on/off
   for (int i = 0; i < 3; i++) {
-    gdm1602a_display_off();
+    gdm1602a_display_off(hlcd);
     HAL_Delay(500);
-    gdm1602a_display_on();
+    gdm1602a_display_on(hlcd);
     HAL_Delay(500);
   }
 
@@ -178,50 +284,52 @@ void gdm1602a_test_display_control(void) {
 
 /**
  * @brief Test 4: Cursor movement
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_cursor_movement(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 4: Move");
+void gdm1602a_test_cursor_movement(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 4: Move");
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Show cursor
-  gdm1602a_cursor_on();
-  gdm1602a_set_cursor(1, 0);
-  gdm1602a_puts("*             *");
+  gdm1602a_cursor_on(hlcd);
+  gdm1602a_set_cursor(hlcd, 1, 0);
+  gdm1602a_puts(hlcd, "*             *");
 
   // Move cursor right
-  gdm1602a_set_cursor(1, 1);
+  gdm1602a_set_cursor(hlcd, 1, 1);
   for (int i = 0; i < 13; i++) {
-    gdm1602a_shift_cursor_right();
+    gdm1602a_shift_cursor_right(hlcd);
     HAL_Delay(200);
   }
 
   // Move cursor left
   for (int i = 0; i < 13; i++) {
-    gdm1602a_shift_cursor_left();
+    gdm1602a_shift_cursor_left(hlcd);
     HAL_Delay(200);
   }
 
-  gdm1602a_cursor_off();
+  gdm1602a_cursor_off(hlcd);
   HAL_Delay(TEST_DELAY_SHORT);
 }
 
 /**
  * @brief Test 5: Display shift (scrolling)
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_display_shift(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 5: Shift");
+void gdm1602a_test_display_shift(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 5: Shift");
   HAL_Delay(TEST_DELAY_SHORT);
 
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Scroll Left>>>>");
-  gdm1602a_printf(1, 0, "1234567890ABCDEF");
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Scroll Left>>>>");
+  gdm1602a_printf(hlcd, 1, 0, "1234567890ABCDEF");
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Shift display left
   for (int i = 0; i < 10; i++) {
-    gdm1602a_shift_display_left();
+    gdm1602a_shift_display_left(hlcd);
     HAL_Delay(300);
   }
 
@@ -229,7 +337,7 @@ void gdm1602a_test_display_shift(void) {
 
   // Shift display right
   for (int i = 0; i < 10; i++) {
-    gdm1602a_shift_display_right();
+    gdm1602a_shift_display_right(hlcd);
     HAL_Delay(300);
   }
 
@@ -238,10 +346,11 @@ void gdm1602a_test_display_shift(void) {
 
 /**
  * @brief Test 6: Custom characters
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_custom_characters(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 6: Custom");
+void gdm1602a_test_custom_characters(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 6: Custom");
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Define custom characters
@@ -264,126 +373,129 @@ void gdm1602a_test_custom_characters(void) {
                         0b11111, 0b11111, 0b11111, 0b11111};
 
   // Create custom characters
-  gdm1602a_create_char(0, heart);
-  gdm1602a_create_char(1, smiley);
-  gdm1602a_create_char(2, bell);
-  gdm1602a_create_char(3, arrow_up);
-  gdm1602a_create_char(4, arrow_down);
-  gdm1602a_create_char(5, battery);
+  gdm1602a_create_char(hlcd, 0, heart);
+  gdm1602a_create_char(hlcd, 1, smiley);
+  gdm1602a_create_char(hlcd, 2, bell);
+  gdm1602a_create_char(hlcd, 3, arrow_up);
+  gdm1602a_create_char(hlcd, 4, arrow_down);
+  gdm1602a_create_char(hlcd, 5, battery);
 
   // Display custom characters
-  gdm1602a_clear();
-  gdm1602a_set_cursor(0, 0);
-  gdm1602a_putchar(0); // Heart
-  gdm1602a_putchar(' ');
-  gdm1602a_putchar(1); // Smiley
-  gdm1602a_putchar(' ');
-  gdm1602a_putchar(2); // Bell
-  gdm1602a_putchar(' ');
-  gdm1602a_puts("Custom!");
-
-  gdm1602a_set_cursor(1, 0);
-  gdm1602a_putchar(3); // Arrow up
-  gdm1602a_putchar(' ');
-  gdm1602a_putchar(4); // Arrow down
-  gdm1602a_putchar(' ');
-  gdm1602a_putchar(5); // Battery
-  gdm1602a_putchar(' ');
-  gdm1602a_puts("Chars");
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 0, 0);
+  gdm1602a_putchar(hlcd, 0); // Heart
+  gdm1602a_putchar(hlcd, ' ');
+  gdm1602a_putchar(hlcd, 1); // Smiley
+  gdm1602a_putchar(hlcd, ' ');
+  gdm1602a_putchar(hlcd, 2); // Bell
+  gdm1602a_putchar(hlcd, ' ');
+  gdm1602a_puts(hlcd, "Custom!");
+
+  gdm1602a_set_cursor(hlcd, 1, 0);
+  gdm1602a_putchar(hlcd, 3); // Arrow up
+  gdm1602a_putchar(hlcd, ' ');
+  gdm1602a_putchar(hlcd, 4); // Arrow down
+  gdm1602a_putchar(hlcd, ' ');
+  gdm1602a_putchar(hlcd, 5); // Battery
+  gdm1602a_putchar(hlcd, ' ');
+  gdm1602a_puts(hlcd, "Chars");
 
   HAL_Delay(TEST_DELAY_LONG);
 }
 
 /**
  * @brief Test 7: Printf functionality
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_printf_function(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 7: Printf");
+void gdm1602a_test_printf_function(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 7: Printf");
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Test integers
-  gdm1602a_clear();
+  gdm1602a_clear(hlcd);
   for (int i = 0; i <= 10; i++) {
-    gdm1602a_printf(0, 0, "Counter: %d", i);
-    gdm1602a_printf(1, 0, "Hex: 0x%02X", i);
+    gdm1602a_printf(hlcd, 0, 0, "Counter: %d", i);
+    gdm1602a_printf(hlcd, 1, 0, "Hex: 0x%02X", i);
     HAL_Delay(300);
   }
 
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Test strings
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Name: %s", "GDM1602A");
-  gdm1602a_printf(1, 0, "MCU: %s", "STM32");
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Name: %s", "GDM1602A");
+  gdm1602a_printf(hlcd, 1, 0, "MCU: %s", "STM32");
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Test mixed types
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Temp: %d C", 25);
-  gdm1602a_printf(1, 0, "Humid: %d%%", 65);
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Temp: %d C", 25);
+  gdm1602a_printf(hlcd, 1, 0, "Humid: %d%%", 65);
   HAL_Delay(TEST_DELAY_MEDIUM);
 }
 
 /**
  * @brief Test 8: Multiline text positioning
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_multiline_text(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 8: Lines");
+void gdm1602a_test_multiline_text(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 8: Lines");
   HAL_Delay(TEST_DELAY_SHORT);
 
   // Test different column positions
-  gdm1602a_clear();
-  gdm1602a_set_cursor(0, 0);
-  gdm1602a_puts("Left");
-  gdm1602a_set_cursor(0, 11);
-  gdm1602a_puts("Right");
-
-  gdm1602a_set_cursor(1, 6);
-  gdm1602a_puts("Center");
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 0, 0);
+  gdm1602a_puts(hlcd, "Left");
+  gdm1602a_set_cursor(hlcd, 0, 11);
+  gdm1602a_puts(hlcd, "Right");
+
+  gdm1602a_set_cursor(hlcd, 1, 6);
+  gdm1602a_puts(hlcd, "Center");
   HAL_Delay(TEST_DELAY_MEDIUM);
 
   // Test home function
-  gdm1602a_clear();
-  gdm1602a_set_cursor(1, 10);
-  gdm1602a_puts("Bottom");
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 1, 10);
+  gdm1602a_puts(hlcd, "Bottom");
   HAL_Delay(TEST_DELAY_SHORT);
 
-  gdm1602a_home(); // Should go to (0,0)
-  gdm1602a_puts("Top (home)");
+  gdm1602a_home(hlcd); // Should go to (0,0)
+  gdm1602a_puts(hlcd, "Top (home)");
   HAL_Delay(TEST_DELAY_MEDIUM);
 }
 
 /**
  * @brief Test 9: Scrolling text animation
+ * @param hlcd Pointer to GDM1602A handle structure
  */
-void gdm1602a_test_scrolling_text(void) {
-  gdm1602a_clear();
-  gdm1602a_printf(0, 0, "Test 9: Scroll");
+void gdm1602a_test_scrolling_text(GDM1602A_HandleTypeDef *hlcd) {
+  gdm1602a_clear(hlcd);
+  gdm1602a_printf(hlcd, 0, 0, "Test 9: Scroll");
   HAL_Delay(TEST_DELAY_SHORT);
 
   const char *long_text = "This is a very long scrolling message!";
   int text_len = strlen(long_text);
 
-  gdm1602a_clear();
-  gdm1602a_set_cursor(0, 0);
-  gdm1602a_puts("Scrolling:");
+  gdm1602a_clear(hlcd);
+  gdm1602a_set_cursor(hlcd, 0, 0);
+  gdm1602a_puts(hlcd, "Scrolling:");
 
   // Scroll text across line 2
   for (int pos = 16; pos > -text_len; pos--) {
-    gdm1602a_set_cursor(1, 0);
-    gdm1602a_puts("                "); // Clear line
+    gdm1602a_set_cursor(hlcd, 1, 0);
+    gdm1602a_puts(hlcd, "                "); // Clear line
 
-    gdm1602a_set_cursor(1, 0);
+    gdm1602a_set_cursor(hlcd, 1, 0);
 
     // Display portion of text that fits on screen
     for (int i = 0; i < 16; i++) {
       int char_index = i - pos;
       if (char_index >= 0 && char_index < text_len) {
-        gdm1602a_putchar(long_text[char_index]);
+        gdm1602a_putchar(hlcd, long_text[char_index]);
       } else {
-        gdm1602a_putchar(' ');
+        gdm1602a_putchar(hlcd, ' ');
       }
     }
 
@@ -1,6 +1,7 @@
 #ifndef GDM1602A_TEST_H
 #define GDM1602A_TEST_H
 
+#include "gdm1602a.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -10,21 +11,31 @@
 #define TEST_DELAY_MEDIUM 2000 // 2 seconds
 #define TEST_DELAY_LONG 3000   // 3 seconds
 
+/* Scenarios are laid out for a 16x2 display */
+#define TEST_ROWS 2
+#define TEST_COLS 16
+
 /* Test function prototypes */
-void gdm1602a_test_all(void);
-void gdm1602a_test_basic_output(void);
-void gdm1602a_test_cursor_control(void);
-void gdm1602a_test_display_control(void);
-void gdm1602a_test_cursor_movement(void);
-void gdm1602a_test_display_shift(void);
-void gdm1602a_test_custom_characters(void);
-void gdm1602a_test_printf_function(void);
-void gdm1602a_test_multiline_text(void);
-void gdm1602a_test_scrolling_text(void);
+void gdm1602a_test_all(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_basic_output(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_cursor_control(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_display_control(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_cursor_movement(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_display_shift(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_custom_characters(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_printf_function(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_multiline_text(GDM1602A_HandleTypeDef *hlcd);
+void gdm1602a_test_scrolling_text(GDM1602A_HandleTypeDef *hlcd);
 
 /* Helper functions */
-void gdm1602a_test_run_single(uint8_t test_number);
+void gdm1602a_test_run_single(GDM1602A_HandleTypeDef *hlcd,
+                              uint8_t test_number);
 const char *gdm1602a_test_get_name(uint8_t test_number);
 uint8_t gdm1602a_test_get_count(void);
+void gdm1602a_test_report(GDM1602A_HandleTypeDef *hlcd, uint8_t test_number);
+const char *gdm1602a_test_get_expected(uint8_t test_number, uint8_t row);
+#if LCD_USE_RW_PIN
+bool gdm1602a_test_verify(GDM1602A_HandleTypeDef *hlcd, uint8_t test_number);
+#endif
 
 #endif
@@ -0,0 +1,151 @@
+#include "gdm1602a_widgets.h"
+
+/* Bar cells filled 1-4 pixel columns from the left */
+#define BAR_PARTIAL_STEPS (GDM1602A_GLYPH_COLS - 1)
+
+static const uint8_t bar_glyphs[BAR_PARTIAL_STEPS][GDM1602A_GLYPH_ROWS] = {
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},
+    {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18},
+    {0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C},
+    {0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E},
+};
+
+/* Big digit segments */
+enum { SEGMENT_UPPER = 0, SEGMENT_LOWER, SEGMENT_BOTH, SEGMENT_COUNT };
+
+static const uint8_t segment_glyphs[SEGMENT_COUNT][GDM1602A_GLYPH_ROWS] = {
+    [SEGMENT_UPPER] = {0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00},
+    [SEGMENT_LOWER] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},
+    [SEGMENT_BOTH] = {0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F},
+};
+
+/**
+ * Big digit layout, top row then bottom row:
+ * U - upper bar, L - lower bar, B - both bars, F - full block, ' ' - blank
+ */
+static const char big_digits[10][2][GDM1602A_BIG_DIGIT_WIDTH + 1] = {
+    {"FUF", "FLF"}, {"UF ", "LFL"}, {"BBF", "FLL"}, {"BBF", "LLF"},
+    {"FLF", "  F"}, {"FBB", "LLF"}, {"FBB", "FLF"}, {"UUF", "  F"},
+    {"FBF", "FLF"}, {"FBF", "LLF"},
+};
+
+static char segment_char(GDM1602A_HandleTypeDef *hlcd, char segment) {
+  switch (segment) {
+  case 'U':
+    return (char)gdm1602a_glyph(hlcd, segment_glyphs[SEGMENT_UPPER]);
+  case 'L':
+    return (char)gdm1602a_glyph(hlcd, segment_glyphs[SEGMENT_LOWER]);
+  case 'B':
+    return (char)gdm1602a_glyph(hlcd, segment_glyphs[SEGMENT_BOTH]);
+  case 'F':
+    return (char)GDM1602A_CHAR_FULL;
+  default:
+    return ' ';
+  }
+}
+
+static void big_digit_draw(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                           uint8_t col, uint8_t digit) {
+  for (uint8_t line = 0; line < 2; line++) {
+    for (uint8_t i = 0; i < GDM1602A_BIG_DIGIT_WIDTH; i++) {
+      char segment = (digit < 10) ? big_digits[digit][line][i] : ' ';
+
+      gdm1602a_fb_set(hlcd, row + line, col + i, segment_char(hlcd, segment));
+    }
+  }
+}
+
+/**
+ * @brief Load all widget glyphs into CGRAM
+ * @param hlcd Pointer to GDM1602A handle structure
+ * @note Uses 7 of the 8 CGRAM slots. Later widget calls find their glyphs in
+ * the glyph cache and send no CGRAM writes
+ */
+void gdm1602a_widgets_preload(GDM1602A_HandleTypeDef *hlcd) {
+  for (uint8_t i = 0; i < BAR_PARTIAL_STEPS; i++) {
+    gdm1602a_glyph(hlcd, bar_glyphs[i]);
+  }
+
+  for (uint8_t i = 0; i < SEGMENT_COUNT; i++) {
+    gdm1602a_glyph(hlcd, segment_glyphs[i]);
+  }
+}
+
+/**
+ * @brief Draw a horizontal bar graph
+ * @param hlcd Pointer to GDM1602A handle structure
+ * @param row Row of the bar
+ * @param col First column of the bar
+ * @param width Bar length in cells, 5 steps per cell
+ * @param value Value to show, clamped to max
+ * @param max Value of a full bar
+ * @return Status of the framebuffer flush
+ * @note Only cells whose level changed are sent to the LCD
+ */
+HAL_StatusTypeDef gdm1602a_bar(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                               uint8_t col, uint8_t width, uint32_t value,
+                               uint32_t max) {
+  uint32_t filled = 0;
+
+  if (max > 0) {
+    if (value > max) {
+      value = max;
+    }
+    filled = (uint64_t)value * width * GDM1602A_GLYPH_COLS / max;
+  }
+
+  for (uint8_t i = 0; i < width; i++) {
+    char c = ' ';
+
+    if (filled >= GDM1602A_GLYPH_COLS) {
+      c = (char)GDM1602A_CHAR_FULL;
+      filled -= GDM1602A_GLYPH_COLS;
+    } else if (filled > 0) {
+      c = (char)gdm1602a_glyph(hlcd, bar_glyphs[filled - 1]);
+      filled = 0;
+    }
+
+    gdm1602a_fb_set(hlcd, row, col + i, c);
+  }
+
+  return gdm1602a_fb_flush(hlcd);
+}
+
+/**
+ * @brief Draw a 3x2 cell digit
+ * @param hlcd Pointer to GDM1602A handle structure
+ * @param row Top row of the digit
+ * @param col Left column of the digit
+ * @param digit Digit 0-9, any other value blanks the cells
+ * @return Status of the framebuffer flush
+ */
+HAL_StatusTypeDef gdm1602a_big_digit(GDM1602A_HandleTypeDef *hlcd,
+                                     uint8_t row, uint8_t col, uint8_t digit) {
+  big_digit_draw(hlcd, row, col, digit);
+  return gdm1602a_fb_flush(hlcd);
+}
+
+/**
+ * @brief Draw a right aligned number with big digits
+ * @param hlcd Pointer to GDM1602A handle structure
+ * @param row Top row of the number
+ * @param col Left column of the number
+ * @param value Number to show
+ * @param digits Number of digit positions, leading zeros are blanked
+ * @return Status of the framebuffer flush
+ * @note Each position takes GDM1602A_BIG_DIGIT_PITCH columns, 4 digits fit on
+ * a 16 column display
+ */
+HAL_StatusTypeDef gdm1602a_big_number(GDM1602A_HandleTypeDef *hlcd,
+                                      uint8_t row, uint8_t col, uint32_t value,
+                                      uint8_t digits) {
+  for (uint8_t i = digits; i > 0; i--) {
+    uint8_t position_col = col + (i - 1) * GDM1602A_BIG_DIGIT_PITCH;
+    bool blank = (value == 0 && i != digits);
+
+    big_digit_draw(hlcd, row, position_col, blank ? 0xFF : value % 10);
+    value /= 10;
+  }
+
+  return gdm1602a_fb_flush(hlcd);
+}
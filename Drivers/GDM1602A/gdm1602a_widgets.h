@@ -0,0 +1,21 @@
+#ifndef GDM1602A_WIDGETS_H
+#define GDM1602A_WIDGETS_H
+
+#include "gdm1602a.h"
+#include <stdint.h>
+
+/* Big digits are 3 cells wide and 2 rows high, plus 1 cell gap */
+#define GDM1602A_BIG_DIGIT_WIDTH 3
+#define GDM1602A_BIG_DIGIT_PITCH 4
+
+void gdm1602a_widgets_preload(GDM1602A_HandleTypeDef *hlcd);
+HAL_StatusTypeDef gdm1602a_bar(GDM1602A_HandleTypeDef *hlcd, uint8_t row,
+                               uint8_t col, uint8_t width, uint32_t value,
+                               uint32_t max);
+HAL_StatusTypeDef gdm1602a_big_digit(GDM1602A_HandleTypeDef *hlcd,
+                                     uint8_t row, uint8_t col, uint8_t digit);
+HAL_StatusTypeDef gdm1602a_big_number(GDM1602A_HandleTypeDef *hlcd,
+                                      uint8_t row, uint8_t col, uint32_t value,
+                                      uint8_t digits);
+
+#endif
@@ -1,5 +1,6 @@
 #include "hw390.h"
 #include "adc.h"
+#include "sleep_ms.h"
 #include "stm32l4xx_hal.h"
 #include "stm32l4xx_hal_adc.h"
 #include <stdbool.h>
@@ -34,7 +35,7 @@ uint32_t hw390_read_average_data(HW390_HandleTypeDef *hhw390, uint16_t samples,
 
   for (uint16_t i = 0; i < samples; i++) {
     sum += hw390_read_data(hhw390, 100);
-    HAL_Delay(delay_ms);
+    sleep_ms(delay_ms);
   }
 
   return (uint32_t)(sum / samples);
@@ -0,0 +1,195 @@
+#include "sensor_hub.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Check if a tick deadline has been reached (wrap-around safe) */
+static bool sensor_hub_deadline_reached(uint32_t deadline) {
+  return (int32_t)(HAL_GetTick() - deadline) >= 0;
+}
+
+static void sensor_hub_poll_aht20(SensorHub_HandleTypeDef *hhub) {
+  HAL_StatusTypeDef status = AHT20_TryCollect(hhub->haht20, NULL, NULL);
+
+  if (status == HAL_BUSY) {
+    return;
+  }
+
+  hhub->pending &= ~SENSOR_HUB_VALID_AHT20;
+
+  if (status == HAL_TIMEOUT) {
+    hhub->status = HAL_TIMEOUT;
+  }
+
+  if (status == HAL_OK) {
+    AHT20_DecodeFrame(hhub->haht20->frame, &hhub->record.aht20_temperature,
+                      &hhub->record.aht20_humidity);
+    hhub->record.valid |= SENSOR_HUB_VALID_AHT20;
+  }
+}
+
+static void sensor_hub_poll_bmp280(SensorHub_HandleTypeDef *hhub) {
+  HAL_StatusTypeDef status;
+  uint8_t status_reg;
+
+  if (!sensor_hub_deadline_reached(hhub->bmp280_deadline)) {
+    return;
+  }
+
+  status = BMP280_ReadStatus(hhub->hbmp280, &status_reg);
+  if (status == HAL_OK && (status_reg & BMP280_STATUS_MEASURING_BIT)) {
+    return;
+  }
+
+  hhub->pending &= ~SENSOR_HUB_VALID_BMP280;
+
+  if (status == HAL_OK) {
+    status = BMP280_ReadAllFixed(hhub->hbmp280,
+                                 &hhub->record.bmp280_temperature,
+                                 &hhub->record.bmp280_pressure);
+  }
+
+  if (status == HAL_OK) {
+    hhub->record.valid |= SENSOR_HUB_VALID_BMP280;
+  }
+}
+
+static void sensor_hub_poll_hw390(SensorHub_HandleTypeDef *hhub) {
+  if (!sensor_hub_deadline_reached(hhub->soil_next_tick)) {
+    return;
+  }
+
+  hhub->soil_sum += hw390_read_data(hhub->hhw390, 100);
+  hhub->soil_count++;
+  hhub->soil_next_tick += hhub->soil_interval;
+
+  if (hhub->soil_count < hhub->soil_samples) {
+    return;
+  }
+
+  hhub->pending &= ~SENSOR_HUB_VALID_HW390;
+
+  hhub->record.soil_adc = (uint32_t)(hhub->soil_sum / hhub->soil_samples);
+  hhub->record.soil_moisture =
+      hw390_get_moisture_percent(hhub->hhw390, hhub->record.soil_adc);
+  hhub->record.valid |= SENSOR_HUB_VALID_HW390;
+}
+
+/**
+ * @brief Initialize sensor hub
+ * @param hhub Pointer to sensor hub handle structure
+ * @param haht20 Pointer to initialized AHT20 handle or NULL
+ * @param hbmp280 Pointer to initialized and configured BMP280 handle or NULL
+ * @param hhw390 Pointer to initialized HW390 handle or NULL
+ * @note HW390 averaging defaults to SENSOR_HUB_SOIL_SAMPLES samples taken
+ * SENSOR_HUB_SOIL_INTERVAL ms apart and the cycle limit to
+ * SENSOR_HUB_CYCLE_TIMEOUT, soil_samples, soil_interval and timeout fields can
+ * be changed afterwards
+ */
+void sensor_hub_init(SensorHub_HandleTypeDef *hhub,
+                     AHT20_HandleTypeDef *haht20,
+                     BMP280_HandleTypeDef *hbmp280,
+                     HW390_HandleTypeDef *hhw390) {
+  hhub->haht20 = haht20;
+  hhub->hbmp280 = hbmp280;
+  hhub->hhw390 = hhw390;
+  hhub->soil_samples = SENSOR_HUB_SOIL_SAMPLES;
+  hhub->soil_interval = SENSOR_HUB_SOIL_INTERVAL;
+  hhub->timeout = SENSOR_HUB_CYCLE_TIMEOUT;
+  hhub->running = 0;
+  hhub->pending = 0;
+  memset(&hhub->record, 0, sizeof(hhub->record));
+}
+
+/**
+ * @brief Start an acquisition cycle on all sensors at once
+ * @param hhub Pointer to sensor hub handle structure
+ * @return HAL_OK if the cycle was started, HAL_BUSY if the previous cycle is
+ * still running
+ * @note Triggers the AHT20 measurement and the BMP280 forced conversion and
+ * takes the first HW390 sample, so all conversions overlap. A sensor whose
+ * trigger fails is left out of the record
+ */
+HAL_StatusTypeDef sensor_hub_start(SensorHub_HandleTypeDef *hhub) {
+  uint32_t now;
+
+  if (hhub->running) {
+    return HAL_BUSY;
+  }
+
+  now = HAL_GetTick();
+
+  hhub->running = 1;
+  hhub->record.tick = now;
+  hhub->record.duration = 0;
+  hhub->record.valid = 0;
+  hhub->status = HAL_OK;
+
+  if (hhub->haht20 != NULL && AHT20_StartMeasurement(hhub->haht20) == HAL_OK) {
+    hhub->pending |= SENSOR_HUB_VALID_AHT20;
+  }
+
+  if (hhub->hbmp280 != NULL && BMP280_TriggerForced(hhub->hbmp280) == HAL_OK) {
+    hhub->bmp280_deadline =
+        now + (BMP280_GetMeasurementTime(hhub->hbmp280) + 999) / 1000;
+    hhub->pending |= SENSOR_HUB_VALID_BMP280;
+  }
+
+  if (hhub->hhw390 != NULL && hhub->soil_samples > 0) {
+    hhub->soil_next_tick = now;
+    hhub->soil_count = 0;
+    hhub->soil_sum = 0;
+    hhub->pending |= SENSOR_HUB_VALID_HW390;
+  }
+
+  return HAL_OK;
+}
+
+/**
+ * @brief Collect results whose deadline has expired
+ * @param hhub Pointer to sensor hub handle structure
+ * @param record Pointer to store the record of the finished cycle
+ * @return HAL_BUSY while any sensor is still converting, HAL_OK when the cycle
+ * is finished and the record was stored, HAL_TIMEOUT when the cycle timeout
+ * expired first or a sensor timed out on its own and the record was stored
+ * without the unfinished sensors, HAL_ERROR if no cycle is running
+ * @note Never blocks, call it from the main loop. Each cycle publishes its
+ * record once, check record valid flags for sensors that failed or timed out
+ */
+HAL_StatusTypeDef sensor_hub_poll(SensorHub_HandleTypeDef *hhub,
+                                  SensorHub_RecordTypeDef *record) {
+  HAL_StatusTypeDef status;
+
+  if (!hhub->running) {
+    return HAL_ERROR;
+  }
+
+  if (hhub->pending & SENSOR_HUB_VALID_AHT20) {
+    sensor_hub_poll_aht20(hhub);
+  }
+
+  if (hhub->pending & SENSOR_HUB_VALID_BMP280) {
+    sensor_hub_poll_bmp280(hhub);
+  }
+
+  if (hhub->pending & SENSOR_HUB_VALID_HW390) {
+    sensor_hub_poll_hw390(hhub);
+  }
+
+  status = hhub->status;
+
+  if (hhub->pending) {
+    if (!sensor_hub_deadline_reached(hhub->record.tick + hhub->timeout)) {
+      return HAL_BUSY;
+    }
+
+    // Drop sensors stuck busy, they stay out of the valid flags
+    hhub->pending = 0;
+    status = HAL_TIMEOUT;
+  }
+
+  hhub->running = 0;
+  hhub->record.duration = HAL_GetTick() - hhub->record.tick;
+  *record = hhub->record;
+
+  return status;
+}
@@ -0,0 +1,65 @@
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include "aht20.h"
+#include "bmp280.h"
+#include "hw390.h"
+#include "stm32l4xx_hal.h"
+#include <stdint.h>
+
+/* Default HW390 averaging */
+#define SENSOR_HUB_SOIL_SAMPLES 10
+#define SENSOR_HUB_SOIL_INTERVAL 100 // [ms]
+
+/* Default limit of one acquisition cycle */
+#define SENSOR_HUB_CYCLE_TIMEOUT 2000 // [ms]
+
+/* Record valid flags */
+#define SENSOR_HUB_VALID_AHT20 (1 << 0)
+#define SENSOR_HUB_VALID_BMP280 (1 << 1)
+#define SENSOR_HUB_VALID_HW390 (1 << 2)
+
+/* One acquisition cycle result */
+typedef struct {
+  uint32_t tick;     // HAL tick when the cycle was started
+  uint32_t duration; // [ms] from start until the last result was collected
+  uint8_t valid;     // SENSOR_HUB_VALID_* flags of collected values
+
+  int32_t aht20_temperature;  // [0.01 degC]
+  int32_t aht20_humidity;     // [0.01 %RH]
+  int32_t bmp280_temperature; // [0.01 degC]
+  uint32_t bmp280_pressure;   // [Pa] unsigned Q24.8
+  uint32_t soil_adc;          // Averaged raw ADC value
+  uint8_t soil_moisture;      // [%]
+} SensorHub_RecordTypeDef;
+
+/* Sensor Hub Handle Structure */
+typedef struct {
+  AHT20_HandleTypeDef *haht20;   // NULL if not fitted
+  BMP280_HandleTypeDef *hbmp280; // NULL if not fitted
+  HW390_HandleTypeDef *hhw390;   // NULL if not fitted
+
+  uint16_t soil_samples;
+  uint16_t soil_interval;
+  uint32_t timeout; // [ms] from start until unfinished sensors are dropped
+
+  /* Cycle state */
+  uint8_t running;
+  uint8_t pending; // SENSOR_HUB_VALID_* flags of values still to collect
+  HAL_StatusTypeDef status; // HAL_TIMEOUT once a sensor timed out itself
+  uint32_t bmp280_deadline;
+  uint32_t soil_next_tick;
+  uint16_t soil_count;
+  uint64_t soil_sum;
+  SensorHub_RecordTypeDef record;
+} SensorHub_HandleTypeDef;
+
+void sensor_hub_init(SensorHub_HandleTypeDef *hhub,
+                     AHT20_HandleTypeDef *haht20,
+                     BMP280_HandleTypeDef *hbmp280,
+                     HW390_HandleTypeDef *hhw390);
+HAL_StatusTypeDef sensor_hub_start(SensorHub_HandleTypeDef *hhub);
+HAL_StatusTypeDef sensor_hub_poll(SensorHub_HandleTypeDef *hhub,
+                                  SensorHub_RecordTypeDef *record);
+
+#endif
@@ -0,0 +1,102 @@
+#include "aht20.h"
+#include "hal_host.h"
+#include <time.h>
+
+/* AHT20_Crc8 against the bitwise CRC-8 of the datasheet (polynomial 0x31,
+ * init 0xFF) and the speed of both on measurement frames */
+
+#define FRAMES 4096
+#define ROUNDS 64
+
+static uint8_t frames[FRAMES][AHT20_FRAME_SIZE];
+
+/* Bit by bit, as specified in the datasheet */
+static uint8_t reference_crc8(const uint8_t *data, uint8_t size) {
+  uint8_t crc = AHT20_CRC_INIT;
+
+  for (uint8_t i = 0; i < size; i++) {
+    crc ^= data[i];
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+static double elapsed_ns(const struct timespec *start) {
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/* Known answers of the Sensirion CRC-8 */
+static void test_known_answers(void) {
+  const uint8_t beef[] = {0xBE, 0xEF};
+  const uint8_t status[] = {0x1C};
+
+  HOST_CHECK(AHT20_Crc8(beef, sizeof(beef)) == 0x92);
+  HOST_CHECK(AHT20_Crc8(status, sizeof(status)) == 0x92);
+  HOST_CHECK(AHT20_Crc8(beef, 0) == AHT20_CRC_INIT);
+}
+
+/* Every single byte value and pseudo-random frames */
+static void test_reference(void) {
+  uint32_t seed = 1;
+
+  for (uint32_t value = 0; value < 256; value++) {
+    uint8_t byte = (uint8_t)value;
+
+    HOST_CHECK(AHT20_Crc8(&byte, 1) == reference_crc8(&byte, 1));
+  }
+
+  for (uint32_t i = 0; i < FRAMES; i++) {
+    for (uint8_t j = 0; j < AHT20_FRAME_SIZE; j++) {
+      seed = seed * 1103515245 + 12345;
+      frames[i][j] = (uint8_t)(seed >> 16);
+    }
+
+    if (AHT20_Crc8(frames[i], AHT20_FRAME_SIZE) !=
+        reference_crc8(frames[i], AHT20_FRAME_SIZE)) {
+      HOST_CHECK(false);
+      break;
+    }
+  }
+}
+
+static void test_speed(void) {
+  volatile uint8_t sink = 0;
+  struct timespec start;
+  double table_ns, bitwise_ns;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    for (uint32_t i = 0; i < FRAMES; i++) {
+      sink ^= AHT20_Crc8(frames[i], AHT20_FRAME_SIZE);
+    }
+  }
+  table_ns = elapsed_ns(&start) / (ROUNDS * FRAMES);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    for (uint32_t i = 0; i < FRAMES; i++) {
+      sink ^= reference_crc8(frames[i], AHT20_FRAME_SIZE);
+    }
+  }
+  bitwise_ns = elapsed_ns(&start) / (ROUNDS * FRAMES);
+
+  printf("AHT20 CRC-8 of a %u byte frame: table %.1f ns, bitwise %.1f ns "
+         "(host)\n",
+         AHT20_FRAME_SIZE, table_ns, bitwise_ns);
+  (void)sink;
+}
+
+int main(void) {
+  test_known_answers();
+  test_reference();
+  test_speed();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,268 @@
+#include "aht20.h"
+#include "aht20_model.h"
+#include "hal_host.h"
+#include <string.h>
+
+/* AHT20 driver against the host sensor model */
+
+static I2C_HandleTypeDef hi2c;
+static HostAHT20TypeDef sensor;
+static AHT20_HandleTypeDef haht20;
+
+static void setup(void) {
+  memset(&hi2c, 0, sizeof(hi2c));
+  hi2c.State = HAL_I2C_STATE_READY;
+
+  host_i2c_detach_all();
+  host_aht20_init(&sensor, AHT20_ADDRESS);
+  host_i2c_attach(&sensor.i2c);
+
+  HOST_CHECK(AHT20_Init(&haht20, &hi2c, AHT20_ADDRESS) == HAL_OK);
+}
+
+/* Without CRC mode a corrupted frame is read as 6 bytes and accepted */
+static void test_crc_disabled(void) {
+  int32_t t, rh;
+
+  setup();
+  sensor.corrupt_frames = 1;
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+  HOST_CHECK(sensor.frame_size == AHT20_FRAME_SIZE);
+  HOST_CHECK(AHT20_GetError(&haht20) == AHT20_ERROR_NONE);
+  HOST_CHECK(rh != 5000);
+}
+
+static void test_crc_enabled(void) {
+  int32_t t, rh;
+
+  setup();
+  AHT20_EnableCrc(&haht20, 1);
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+  HOST_CHECK(sensor.frame_size == AHT20_FRAME_SIZE_CRC);
+  HOST_CHECK(AHT20_GetError(&haht20) == AHT20_ERROR_NONE);
+  HOST_CHECK(t == 2500);
+  HOST_CHECK(rh == 5000);
+
+  AHT20_EnableCrc(&haht20, 0);
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+  HOST_CHECK(sensor.frame_size == AHT20_FRAME_SIZE);
+}
+
+/* A corrupted frame is reported as AHT20_ERROR_CRC, the retry succeeds */
+static void test_crc_mismatch(void) {
+  int32_t t = 0, rh = 0;
+
+  setup();
+  AHT20_EnableCrc(&haht20, 1);
+  sensor.corrupt_frames = 1;
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_ERROR);
+  HOST_CHECK(AHT20_GetError(&haht20) == AHT20_ERROR_CRC);
+  HOST_CHECK(t == 0 && rh == 0);
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+  HOST_CHECK(AHT20_GetError(&haht20) == AHT20_ERROR_NONE);
+  HOST_CHECK(rh == 5000);
+}
+
+/* The blocking read polls the frame every AHT20_POLL_DELAY ms until ready */
+static void test_measure_polls(void) {
+  int32_t t, rh;
+  uint32_t start;
+
+  for (uint32_t polls = 1; polls <= AHT20_POLL_RETRIES; polls++) {
+    setup();
+    sensor.measure_ms = AHT20_MEASURE_DELAY + (polls - 1) * AHT20_POLL_DELAY;
+    start = host_tick;
+
+    HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+    HOST_CHECK(sensor.frame_reads == polls);
+    HOST_CHECK(host_tick - start == sensor.measure_ms);
+    HOST_CHECK(t == 2500 && rh == 5000);
+  }
+
+  // One poll delay too slow
+  setup();
+  sensor.measure_ms = AHT20_COLLECT_TIMEOUT;
+  t = rh = -1;
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_TIMEOUT);
+  HOST_CHECK(sensor.frame_reads == AHT20_POLL_RETRIES);
+  HOST_CHECK(t == -1 && rh == -1);
+}
+
+/* A sensor that never finishes fails the read instead of returning old data */
+static void test_measure_stuck(void) {
+  int32_t t, rh;
+  float temperature = -1.0f;
+  uint32_t start;
+
+  setup();
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+
+  sensor.stuck = 1;
+  sensor.raw_temperature = 0;
+  t = rh = -1;
+  start = host_tick;
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_TIMEOUT);
+  HOST_CHECK(host_tick - start == AHT20_COLLECT_TIMEOUT);
+  HOST_CHECK(t == -1 && rh == -1);
+
+  HOST_CHECK(AHT20_ReadTemperature(&haht20, &temperature) == HAL_TIMEOUT);
+  HOST_CHECK(temperature == -1.0f);
+}
+
+/* Poll TryCollect every ms like a main loop, returns the first result that is
+ * not HAL_BUSY and the ms it took since the trigger */
+static HAL_StatusTypeDef collect(float *t, float *rh, uint32_t *elapsed) {
+  HAL_StatusTypeDef status;
+  uint32_t start = host_tick;
+
+  HOST_CHECK(AHT20_StartMeasurement(&haht20) == HAL_OK);
+
+  // Bounded so a driver without timeout fails instead of hanging
+  while ((status = AHT20_TryCollect(&haht20, t, rh)) == HAL_BUSY &&
+         host_tick - start <= AHT20_COLLECT_TIMEOUT) {
+    host_advance_ms(1);
+  }
+
+  *elapsed = host_tick - start;
+  return status;
+}
+
+static void test_try_collect(void) {
+  float t = 0.0f, rh = 0.0f;
+  uint32_t elapsed;
+
+  setup();
+
+  HOST_CHECK(AHT20_TryCollect(&haht20, &t, &rh) == HAL_ERROR);
+
+  HOST_CHECK(collect(&t, &rh, &elapsed) == HAL_OK);
+  HOST_CHECK(elapsed == AHT20_MEASURE_DELAY);
+  HOST_CHECK(sensor.frame_reads == 1);
+  HOST_CHECK(t == 25.0f && rh == 50.0f);
+
+  // Collected measurements are not collected twice
+  HOST_CHECK(AHT20_TryCollect(&haht20, &t, &rh) == HAL_ERROR);
+}
+
+/* A sensor slower than AHT20_MEASURE_DELAY is polled until it is ready */
+static void test_try_collect_busy(void) {
+  float t = 0.0f, rh = 0.0f;
+  uint32_t elapsed;
+
+  setup();
+  sensor.measure_ms = AHT20_MEASURE_DELAY + 10;
+
+  HOST_CHECK(collect(&t, &rh, &elapsed) == HAL_OK);
+  HOST_CHECK(elapsed == sensor.measure_ms);
+  HOST_CHECK(sensor.frame_reads == 11);
+  HOST_CHECK(AHT20_GetError(&haht20) == AHT20_ERROR_NONE);
+  HOST_CHECK(rh == 50.0f);
+}
+
+/* A sensor stuck busy ends the measurement after AHT20_COLLECT_TIMEOUT */
+static void test_try_collect_timeout(void) {
+  float t = 0.0f, rh = 0.0f;
+  uint32_t elapsed;
+
+  setup();
+  sensor.stuck = 1;
+
+  HOST_CHECK(collect(&t, &rh, &elapsed) == HAL_TIMEOUT);
+  HOST_CHECK(elapsed == AHT20_COLLECT_TIMEOUT);
+  HOST_CHECK(t == 0.0f && rh == 0.0f);
+  HOST_CHECK(AHT20_TryCollect(&haht20, &t, &rh) == HAL_ERROR);
+
+  // A new measurement after recovery is collected normally
+  sensor.stuck = 0;
+  HOST_CHECK(collect(&t, &rh, &elapsed) == HAL_OK);
+  HOST_CHECK(rh == 50.0f);
+}
+
+/* Reads inside the max age share one measurement */
+static void test_cache_hit(void) {
+  float t = 0.0f, rh = 0.0f;
+
+  setup();
+
+  HOST_CHECK(AHT20_ReadTemperature(&haht20, &t) == HAL_OK);
+  HOST_CHECK(sensor.measurements == 1);
+
+  host_advance_ms(AHT20_CACHE_MAX_AGE - AHT20_MEASURE_DELAY - 1);
+  HOST_CHECK(AHT20_ReadHumidity(&haht20, &rh) == HAL_OK);
+  HOST_CHECK(AHT20_ReadTemperature(&haht20, &t) == HAL_OK);
+  HOST_CHECK(sensor.measurements == 1);
+  HOST_CHECK(sensor.frame_reads == 1);
+  HOST_CHECK(t == 25.0f && rh == 50.0f);
+}
+
+/* An expired frame is measured again */
+static void test_cache_expired(void) {
+  float rh = 0.0f;
+
+  setup();
+
+  HOST_CHECK(AHT20_ReadHumidity(&haht20, &rh) == HAL_OK);
+  host_advance_ms(AHT20_CACHE_MAX_AGE);
+  sensor.raw_humidity = HOST_AHT20_RAW_HUMIDITY / 2;
+
+  HOST_CHECK(AHT20_ReadHumidity(&haht20, &rh) == HAL_OK);
+  HOST_CHECK(sensor.measurements == 2);
+  HOST_CHECK(rh == 25.0f);
+
+  // A max age of 0 disables the cache
+  AHT20_SetCacheMaxAge(&haht20, 0);
+  HOST_CHECK(AHT20_ReadHumidity(&haht20, &rh) == HAL_OK);
+  HOST_CHECK(sensor.measurements == 3);
+}
+
+/* A failed read drops the cached frame instead of serving it */
+static void test_cache_invalidated(void) {
+  float t = 0.0f, rh = 0.0f;
+
+  setup();
+  AHT20_EnableCrc(&haht20, 1);
+
+  HOST_CHECK(AHT20_ReadAll(&haht20, &t, &rh) == HAL_OK);
+  sensor.corrupt_frames = 1;
+  HOST_CHECK(AHT20_ReadAll(&haht20, &t, &rh) == HAL_ERROR);
+  HOST_CHECK(AHT20_GetError(&haht20) == AHT20_ERROR_CRC);
+
+  HOST_CHECK(AHT20_ReadHumidity(&haht20, &rh) == HAL_OK);
+  HOST_CHECK(sensor.measurements == 3);
+
+  sensor.stuck = 1;
+  HOST_CHECK(AHT20_ReadAll(&haht20, &t, &rh) == HAL_TIMEOUT);
+  HOST_CHECK(AHT20_ReadTemperature(&haht20, &t) == HAL_TIMEOUT);
+
+  // Same for a measurement collected without blocking
+  sensor.stuck = 0;
+  HOST_CHECK(AHT20_ReadAll(&haht20, &t, &rh) == HAL_OK);
+  HOST_CHECK(AHT20_StartMeasurement(&haht20) == HAL_OK);
+  sensor.corrupt_frames = 1;
+  host_advance_ms(AHT20_MEASURE_DELAY);
+  HOST_CHECK(AHT20_TryCollect(&haht20, &t, &rh) == HAL_ERROR);
+  HOST_CHECK(AHT20_ReadHumidity(&haht20, &rh) == HAL_OK);
+  HOST_CHECK(sensor.measurements == 6);
+}
+
+int main(void) {
+  test_crc_disabled();
+  test_crc_enabled();
+  test_crc_mismatch();
+  test_measure_polls();
+  test_measure_stuck();
+  test_try_collect();
+  test_try_collect_busy();
+  test_try_collect_timeout();
+  test_cache_hit();
+  test_cache_expired();
+  test_cache_invalidated();
+
+  return HOST_RESULT();
+}
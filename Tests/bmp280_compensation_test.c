@@ -0,0 +1,164 @@
+#include "bmp280.h"
+#include "hal_host.h"
+#include <math.h>
+#include <time.h>
+
+/* Accuracy and speed of the pressure compensation backend selected by
+ * BMP280_USE_32BIT_COMPENSATION. Both backends are checked against the
+ * datasheet's double precision formula over the raw ADC range, limited to the
+ * specified operating range (-40..85 degC, 300..1100 hPa) */
+
+#if BMP280_USE_32BIT_COMPENSATION
+#define BACKEND_NAME "32-bit"
+#define MAX_ERROR_PA 7.0 // 1 Pa resolution plus the 32-bit formula error
+#else
+#define BACKEND_NAME "64-bit"
+#define MAX_ERROR_PA 1.0
+#endif
+
+#define ADC_STEP_T 2048
+#define ADC_STEP_P 256
+#define ADC_RANGE (1 << 20)
+#define BATCH_SIZE (ADC_RANGE / ADC_STEP_P)
+
+/* Calibration example from the datasheet, section 3.12 */
+static BMP280_HandleTypeDef hbmp280 = {
+    .dig_T1 = 27504,
+    .dig_T2 = 26435,
+    .dig_T3 = -1000,
+    .dig_P1 = 36477,
+    .dig_P2 = -10685,
+    .dig_P3 = 3024,
+    .dig_P4 = 2855,
+    .dig_P5 = 140,
+    .dig_P6 = -7,
+    .dig_P7 = 15500,
+    .dig_P8 = -14600,
+    .dig_P9 = 6000,
+};
+
+static uint8_t raw[BATCH_SIZE][BMP280_DATA_REGISTERS_COUNT];
+static int32_t temperature[BATCH_SIZE];
+static uint32_t pressure[BATCH_SIZE];
+
+static void pack_raw(uint8_t *data, int32_t adc) {
+  data[0] = (uint8_t)(adc >> 12);
+  data[1] = (uint8_t)(adc >> 4);
+  data[2] = (uint8_t)(adc << 4);
+}
+
+/* Floating point formula from the datasheet, section 8.1 */
+static double reference_t_fine(int32_t adc_T) {
+  double var1 = ((double)adc_T / 16384.0 - hbmp280.dig_T1 / 1024.0) *
+                hbmp280.dig_T2;
+  double var2 = (double)adc_T / 131072.0 - hbmp280.dig_T1 / 8192.0;
+
+  return var1 + var2 * var2 * hbmp280.dig_T3;
+}
+
+static double reference_pressure(double t_fine, int32_t adc_P) {
+  double var1 = t_fine / 2.0 - 64000.0;
+  double var2 = var1 * var1 * hbmp280.dig_P6 / 32768.0;
+  double p;
+
+  var2 = var2 + var1 * hbmp280.dig_P5 * 2.0;
+  var2 = var2 / 4.0 + hbmp280.dig_P4 * 65536.0;
+  var1 = (hbmp280.dig_P3 * var1 * var1 / 524288.0 + hbmp280.dig_P2 * var1) /
+         524288.0;
+  var1 = (1.0 + var1 / 32768.0) * hbmp280.dig_P1;
+
+  p = 1048576.0 - adc_P;
+  p = (p - var2 / 4096.0) * 6250.0 / var1;
+  var1 = hbmp280.dig_P9 * p * p / 2147483648.0;
+  var2 = p * hbmp280.dig_P8 / 32768.0;
+
+  return p + (var1 + var2 + hbmp280.dig_P7) / 16.0;
+}
+
+static double elapsed_ns(const struct timespec *start) {
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/* Datasheet example: adc_T 519888, adc_P 415148 -> 25.08 degC, 100653 Pa
+ * (100653.27 Pa with the floating point formula) */
+static void test_datasheet_example(void) {
+  uint8_t sample[1][BMP280_DATA_REGISTERS_COUNT];
+  int32_t t;
+  uint32_t p;
+
+  pack_raw(&sample[0][0], 415148);
+  pack_raw(&sample[0][3], 519888);
+
+  BMP280_CompensateBatch(&hbmp280, (const uint8_t(*)[6])sample, 1, &t, &p);
+
+  HOST_CHECK(t == 2508);
+#if BMP280_USE_32BIT_COMPENSATION
+  HOST_CHECK(p == 100656U << 8); // Integer Pa, 2.75 Pa above the 64-bit path
+#else
+  HOST_CHECK(p == 25767233); // 100653.25 Pa
+#endif
+}
+
+static void test_raw_range(void) {
+  double max_error = 0.0;
+  double error_sum = 0.0;
+  double time_ns = 0.0;
+  uint32_t samples = 0;
+  uint32_t computed = 0;
+
+  for (int32_t adc_T = 0; adc_T < ADC_RANGE; adc_T += ADC_STEP_T) {
+    double t_fine = reference_t_fine(adc_T);
+    double t = t_fine / 5120.0;
+    struct timespec start;
+
+    if (t < -40.0 || t > 85.0) {
+      continue;
+    }
+
+    for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+      pack_raw(&raw[i][0], (int32_t)(i * ADC_STEP_P));
+      pack_raw(&raw[i][3], adc_T);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    BMP280_CompensateBatch(&hbmp280, (const uint8_t(*)[6])raw, BATCH_SIZE,
+                           temperature, pressure);
+    time_ns += elapsed_ns(&start);
+    computed += BATCH_SIZE;
+
+    for (uint32_t i = 0; i < BATCH_SIZE; i++) {
+      double p_ref = reference_pressure(t_fine, (int32_t)(i * ADC_STEP_P));
+      double error;
+
+      if (p_ref < 30000.0 || p_ref > 110000.0) {
+        continue;
+      }
+
+      error = fabs(pressure[i] / 256.0 - p_ref);
+      error_sum += error;
+      samples++;
+
+      if (error > max_error) {
+        max_error = error;
+      }
+    }
+  }
+
+  printf("BMP280 %s compensation: %u samples, max error %.2f Pa, "
+         "mean error %.2f Pa, %.1f ns/sample (host)\n",
+         BACKEND_NAME, (unsigned)samples, max_error, error_sum / samples,
+         time_ns / computed);
+
+  HOST_CHECK(samples > 0);
+  HOST_CHECK(max_error <= MAX_ERROR_PA);
+}
+
+int main(void) {
+  test_datasheet_example();
+  test_raw_range();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,187 @@
+#include "bmp280.h"
+#include "bmp280_model.h"
+#include "hal_host.h"
+#include "main.h"
+#include <string.h>
+
+/* BMP280 driver against the host sensor model */
+
+static I2C_HandleTypeDef hi2c;
+static HostBMP280TypeDef sensor;
+static BMP280_HandleTypeDef hbmp280;
+
+static uint8_t flash_page[FLASH_PAGE_SIZE] __attribute__((aligned(8)));
+#define FLASH_PAGE_ADDRESS ((uint32_t)(uintptr_t)flash_page)
+
+static void setup(void) {
+  memset(&hi2c, 0, sizeof(hi2c));
+  hi2c.State = HAL_I2C_STATE_READY;
+
+  host_i2c_detach_all();
+  host_bmp280_init(&sensor, BMP280_ADDRESS_0);
+  host_i2c_attach(&sensor.i2c);
+
+  HOST_CHECK(BMP280_Init(&hbmp280, &hi2c, BMP280_ADDRESS_0) == HAL_OK);
+}
+
+/* An asynchronous read must not change the oversampling used by forced mode */
+static void test_forced_after_poll(void) {
+  int32_t t;
+  uint32_t p;
+
+  setup();
+  HOST_CHECK(BMP280_Configure(&hbmp280, BMP280_STANDBY_0_5MS,
+                              BMP280_FILTER_OFF, BMP280_OVERSAMPLING_1X,
+                              BMP280_OVERSAMPLING_1X,
+                              BMP280_MODE_SLEEP) == HAL_OK);
+
+  HOST_CHECK(BMP280_MeasureForced(&hbmp280, &t, &p) == HAL_OK);
+  HOST_CHECK(BMP280_StartReadAll(&hbmp280) == HAL_OK);
+  HOST_CHECK(BMP280_Poll(&hbmp280, &t, &p) == HAL_OK);
+
+  HOST_CHECK(hbmp280.temp_oversamp == BMP280_OVERSAMPLING_1X);
+  HOST_CHECK(hbmp280.press_oversamp == BMP280_OVERSAMPLING_1X);
+
+  HOST_CHECK(BMP280_MeasureForced(&hbmp280, &t, &p) == HAL_OK);
+  HOST_CHECK(host_bmp280_raw_temperature(&sensor) == HOST_BMP280_ADC_T);
+  HOST_CHECK(host_bmp280_raw_pressure(&sensor) == HOST_BMP280_ADC_P);
+  HOST_CHECK(t == 2508);
+  HOST_CHECK(p == 25767233);
+}
+
+/* Cache with a record of the model's calibration */
+static void setup_cache(void) {
+  setup();
+  memset(flash_page, 0xFF, sizeof(flash_page));
+  host_flash_page = flash_page;
+
+  HOST_CHECK(BMP280_InitCached(&hbmp280, &hi2c, BMP280_ADDRESS_0,
+                               FLASH_PAGE_ADDRESS) == HAL_OK);
+
+  memset(&hbmp280, 0, sizeof(hbmp280));
+  sensor.i2c.transfers = 0;
+  sensor.trimming_reads = 0;
+}
+
+/* A valid record restores the calibration without reading the trimming
+ * registers, and the chip ID only with BMP280_CALIBRATION_CHECK_CHIP_ID */
+static void test_calibration_cache_hit(void) {
+  setup_cache();
+
+  HOST_CHECK(BMP280_InitCached(&hbmp280, &hi2c, BMP280_ADDRESS_0,
+                               FLASH_PAGE_ADDRESS) == HAL_OK);
+  HOST_CHECK(sensor.trimming_reads == 0);
+  HOST_CHECK(sensor.i2c.transfers == BMP280_CALIBRATION_CHECK_CHIP_ID);
+  HOST_CHECK(hbmp280.chip_id == BMP280_CHIP_ID);
+  HOST_CHECK(hbmp280.dig_T1 == 27504);
+  HOST_CHECK(hbmp280.dig_P9 == 6000);
+}
+
+/* The record holds the chip ID read from the sensor */
+static void test_calibration_cache_chip_id(void) {
+  BMP280_CalibrationTypeDef *record = (BMP280_CalibrationTypeDef *)flash_page;
+
+  setup_cache();
+  HOST_CHECK(record->chip_id == BMP280_CHIP_ID);
+
+  // Another part type answering at the address
+  sensor.i2c.regs[BMP280_REG_CHIP_ID] = 0x60;
+  hbmp280.hi2c = &hi2c;
+  hbmp280.address = BMP280_ADDRESS_0;
+  hbmp280.calibration_flash_address = FLASH_PAGE_ADDRESS;
+
+#if BMP280_CALIBRATION_CHECK_CHIP_ID
+  HOST_CHECK(BMP280_LoadCalibration(&hbmp280) == HAL_ERROR);
+  HOST_CHECK(BMP280_InitCached(&hbmp280, &hi2c, BMP280_ADDRESS_0,
+                               FLASH_PAGE_ADDRESS) == HAL_ERROR);
+#else
+  HOST_CHECK(BMP280_LoadCalibration(&hbmp280) == HAL_OK);
+  HOST_CHECK(sensor.i2c.transfers == 0);
+#endif
+}
+
+/* Records of another address or with a bad checksum are rewritten */
+static void test_calibration_cache_miss(void) {
+  BMP280_CalibrationTypeDef *record = (BMP280_CalibrationTypeDef *)flash_page;
+
+  setup_cache();
+  record->address = BMP280_ADDRESS_1;
+
+  HOST_CHECK(BMP280_InitCached(&hbmp280, &hi2c, BMP280_ADDRESS_0,
+                               FLASH_PAGE_ADDRESS) == HAL_OK);
+  HOST_CHECK(sensor.trimming_reads == 1);
+  HOST_CHECK(record->address == BMP280_ADDRESS_0);
+
+  record->dig_T1 ^= 1;
+  memset(&hbmp280, 0, sizeof(hbmp280));
+  sensor.trimming_reads = 0;
+
+  HOST_CHECK(BMP280_InitCached(&hbmp280, &hi2c, BMP280_ADDRESS_0,
+                               FLASH_PAGE_ADDRESS) == HAL_OK);
+  HOST_CHECK(sensor.trimming_reads == 1);
+  HOST_CHECK(hbmp280.dig_T1 == 27504);
+  HOST_CHECK(record->dig_T1 == 27504);
+}
+
+/* Stale error flags are cleared before the erase */
+static void test_calibration_save_stale_errors(void) {
+  BMP280_CalibrationTypeDef *record = (BMP280_CalibrationTypeDef *)flash_page;
+
+  setup();
+  memset(flash_page, 0xA5, sizeof(flash_page));
+  memset(&host_flash, 0, sizeof(host_flash));
+  host_flash_page = flash_page;
+  host_flash_stale_errors = FLASH_FLAG_PGSERR | FLASH_FLAG_OPTVERR;
+
+  HOST_CHECK(BMP280_SaveCalibration(&hbmp280) == HAL_OK);
+  HOST_CHECK(record->magic == BMP280_CALIBRATION_STRUCT_MAGIC);
+
+  host_flash_stale_errors = 0;
+}
+
+/* The erased bank follows the bank swap, the page stays bank-relative */
+static void test_calibration_save_bank_swap(void) {
+  uint32_t bank, page;
+
+  setup();
+  host_flash_page = flash_page;
+  hbmp280.calibration_flash_address = FLASH_PAGE_ADDRESS;
+
+  memset(&host_syscfg, 0, sizeof(host_syscfg));
+  HOST_CHECK(BMP280_SaveCalibration(&hbmp280) == HAL_OK);
+  bank = host_flash_erase.Banks;
+  page = host_flash_erase.Page;
+  HOST_CHECK(page < FLASH_BANK_SIZE / FLASH_PAGE_SIZE);
+
+  host_syscfg.MEMRMP = SYSCFG_MEMRMP_FB_MODE;
+  HOST_CHECK(BMP280_SaveCalibration(&hbmp280) == HAL_OK);
+  HOST_CHECK(host_flash_erase.Banks != bank);
+  HOST_CHECK(host_flash_erase.Page == page);
+
+  memset(&host_syscfg, 0, sizeof(host_syscfg));
+}
+
+/* Flash is not erased when it cannot be unlocked */
+static void test_calibration_save_unlock_failure(void) {
+  setup();
+  memset(flash_page, 0xA5, sizeof(flash_page));
+  host_flash_page = flash_page;
+  host_flash_unlock_status = HAL_ERROR;
+
+  HOST_CHECK(BMP280_SaveCalibration(&hbmp280) == HAL_ERROR);
+  HOST_CHECK(flash_page[0] == 0xA5);
+
+  host_flash_unlock_status = HAL_OK;
+}
+
+int main(void) {
+  test_forced_after_poll();
+  test_calibration_cache_hit();
+  test_calibration_cache_chip_id();
+  test_calibration_cache_miss();
+  test_calibration_save_stale_errors();
+  test_calibration_save_bank_swap();
+  test_calibration_save_unlock_failure();
+
+  return HOST_RESULT();
+}
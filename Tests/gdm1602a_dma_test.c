@@ -0,0 +1,305 @@
+#include "gdm1602a.h"
+#include "hal_host.h"
+#include "hd44780_model.h"
+#include <string.h>
+
+/* Background refresh replayed word by word into the HD44780 model: the BSRR
+ * stream must leave DDRAM and CGRAM as the framebuffer says, and the handle
+ * must follow only once the transfer completes */
+
+static const GDM1602A_PinMapTypeDef pins = LCD_PIN_MAP_DEFAULT;
+
+static GDM1602A_HandleTypeDef hlcd;
+static HostHD44780TypeDef lcd;
+static uint32_t refresh_callbacks;
+
+void gdm1602a_refresh_cplt_callback(GDM1602A_HandleTypeDef *hlcd) {
+  refresh_callbacks++;
+}
+
+static void setup(void) {
+  uint16_t db[8];
+
+  for (uint8_t i = 0; i < 8; i++) {
+    db[i] = pins.db[i].pin;
+  }
+
+  memset(&host_gpioc, 0, sizeof(host_gpioc));
+  host_dma_start_status = HAL_OK;
+  host_dma_error = false;
+  host_dma_length = 0;
+  refresh_callbacks = 0;
+
+  host_hd44780_init(&lcd, GPIOC, pins.rs.pin, 0, pins.e.pin, db);
+  gdm1602a_init(&hlcd, &pins, GDM1602A_GEOMETRY_16X2);
+  HOST_CHECK(gdm1602a_refresh_init());
+}
+
+static bool lcd_row_is(uint8_t address, const char *text) {
+  char row[GDM1602A_MAX_COLS];
+
+  host_hd44780_row(&lcd, address, strlen(text), row);
+  return memcmp(row, text, strlen(text)) == 0;
+}
+
+/* Clock the words out and raise the transfer complete interrupt */
+static void complete_refresh(void) {
+  host_dma_replay(LCD_DMA_TICK_US);
+  gdm1602a_dma_irq_handler();
+}
+
+static void test_replay(void) {
+  setup();
+
+  gdm1602a_fb_write(&hlcd, 0, 0, "Hello");
+  gdm1602a_fb_write(&hlcd, 1, 11, "World");
+
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  HOST_CHECK(gdm1602a_refresh_busy());
+  HOST_CHECK(host_dma_length > 0);
+
+  // Nothing is on the LCD until the words are clocked out
+  HOST_CHECK(hlcd.shadow[0] == ' ');
+  HOST_CHECK(hlcd.address == GDM1602A_LINE1_START);
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "     "));
+
+  host_dma_replay(LCD_DMA_TICK_US);
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "Hello"));
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE2_START + 11, "World"));
+  HOST_CHECK(hlcd.shadow[0] == ' ');
+  HOST_CHECK(gdm1602a_refresh_busy());
+
+  gdm1602a_dma_irq_handler();
+  HOST_CHECK(!gdm1602a_refresh_busy());
+  HOST_CHECK(refresh_callbacks == 1);
+  HOST_CHECK(memcmp(hlcd.shadow, hlcd.framebuffer, 32) == 0);
+  HOST_CHECK(hlcd.address == lcd.ac);
+  HOST_CHECK(host_tim6.CR1 == 0);
+
+  // Already on the LCD, nothing to send
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  HOST_CHECK(!gdm1602a_refresh_busy());
+  HOST_CHECK(refresh_callbacks == 2);
+}
+
+static void test_sync_busy(void) {
+  uint32_t instructions, data_writes;
+  uint8_t display_control;
+
+  setup();
+
+  gdm1602a_fb_write(&hlcd, 0, 0, "Async");
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+
+  instructions = lcd.instructions;
+  data_writes = lcd.data_writes;
+  display_control = hlcd.display_control;
+
+  HOST_CHECK(gdm1602a_putchar(&hlcd, 'X') == HAL_BUSY);
+  HOST_CHECK(gdm1602a_puts(&hlcd, "XY") == HAL_BUSY);
+  HOST_CHECK(gdm1602a_fb_flush(&hlcd) == HAL_BUSY);
+  HOST_CHECK(gdm1602a_clear(&hlcd) == HAL_BUSY);
+  HOST_CHECK(gdm1602a_set_cursor(&hlcd, 1, 0) == HAL_BUSY);
+  HOST_CHECK(gdm1602a_display_off(&hlcd) == HAL_BUSY);
+  HOST_CHECK(gdm1602a_shift_cursor_right(&hlcd) == HAL_BUSY);
+  HOST_CHECK(gdm1602a_printf(&hlcd, 1, 0, "%d", 42) == HAL_BUSY);
+
+  // No pin moved and the handle still describes the LCD
+  HOST_CHECK(lcd.instructions == instructions);
+  HOST_CHECK(lcd.data_writes == data_writes);
+  HOST_CHECK(hlcd.display_control == display_control);
+  HOST_CHECK(hlcd.framebuffer[0] == 'A');
+  HOST_CHECK(hlcd.address == GDM1602A_LINE1_START);
+
+  complete_refresh();
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "Async"));
+
+  // The printf that found the bus busy is flushed by the next call
+  HOST_CHECK(gdm1602a_putchar(&hlcd, '!') == HAL_OK);
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "Async!"));
+  HOST_CHECK(gdm1602a_fb_flush(&hlcd) == HAL_OK);
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE2_START, "42"));
+}
+
+/* Cells changed during the transfer were not part of it and stay dirty */
+static void test_framebuffer_changed_during_refresh(void) {
+  setup();
+
+  gdm1602a_fb_write(&hlcd, 0, 0, "AAAA");
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  gdm1602a_fb_write(&hlcd, 0, 2, "BB");
+  complete_refresh();
+
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "AAAA"));
+  HOST_CHECK(memcmp(hlcd.shadow, "AAAA", 4) == 0);
+
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  complete_refresh();
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "AABB"));
+  HOST_CHECK(hlcd.address == lcd.ac);
+}
+
+/* A transfer that never started must not mark its cells as sent */
+static void test_start_failure(void) {
+  setup();
+
+  gdm1602a_fb_write(&hlcd, 1, 0, "Retry");
+  host_dma_start_status = HAL_ERROR;
+  HOST_CHECK(!gdm1602a_fb_flush_async(&hlcd));
+  HOST_CHECK(!gdm1602a_refresh_busy());
+  HOST_CHECK(hlcd.shadow[16] == ' ');
+
+  host_dma_start_status = HAL_OK;
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  complete_refresh();
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE2_START, "Retry"));
+}
+
+/* After a transfer error the next refresh sets the address again */
+static void test_transfer_error(void) {
+  setup();
+
+  gdm1602a_fb_write(&hlcd, 0, 0, "Lost");
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  host_dma_error = true;
+  gdm1602a_dma_irq_handler();
+  HOST_CHECK(!gdm1602a_refresh_busy());
+  HOST_CHECK(refresh_callbacks == 0);
+  HOST_CHECK(hlcd.shadow[0] == ' ');
+
+  host_dma_error = false;
+  lcd.ac = 0x20; // Wherever the aborted transfer left it
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  complete_refresh();
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, "Lost"));
+  HOST_CHECK(hlcd.address == lcd.ac);
+}
+
+/* A glyph cached during a transfer is loaded by the next one */
+static void test_glyph_during_refresh(void) {
+  static const uint8_t arrow[GDM1602A_GLYPH_ROWS] = {0x04, 0x0E, 0x1F, 0x04,
+                                                     0x04, 0x04, 0x04, 0x00};
+  uint32_t instructions;
+  uint8_t code;
+
+  setup();
+
+  gdm1602a_fb_write(&hlcd, 0, 0, "Up");
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+
+  instructions = lcd.instructions;
+  code = gdm1602a_glyph(&hlcd, arrow);
+  HOST_CHECK(code < GDM1602A_CGRAM_SLOTS);
+  HOST_CHECK(lcd.instructions == instructions);
+  HOST_CHECK(gdm1602a_create_char(&hlcd, 7, (uint8_t *)arrow) == HAL_BUSY);
+  gdm1602a_fb_set(&hlcd, 0, 2, (char)code);
+
+  complete_refresh();
+  HOST_CHECK(hlcd.glyph_pending == (1 << code));
+
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  complete_refresh();
+  HOST_CHECK(hlcd.glyph_pending == 0);
+  HOST_CHECK(memcmp(&lcd.cgram[code * 8], arrow, GDM1602A_GLYPH_ROWS) == 0);
+  HOST_CHECK(lcd.ddram[GDM1602A_LINE1_START + 2] == code);
+  HOST_CHECK(!lcd.cgram_mode);
+  HOST_CHECK(hlcd.address == lcd.ac);
+}
+
+/* The worst case diff of the configured geometry fits the word buffer */
+static void test_worst_case(void) {
+  uint8_t glyph[GDM1602A_GLYPH_ROWS] = {0};
+  char expected[2][17] = {"", ""};
+
+  setup();
+
+  for (uint8_t slot = 0; slot < GDM1602A_CGRAM_SLOTS; slot++) {
+    glyph[0] = slot + 1;
+    HOST_CHECK(gdm1602a_glyph(&hlcd, glyph) == slot);
+  }
+
+  // Every other cell changes, so each needs its own address set
+  for (uint8_t row = 0; row < 2; row++) {
+    memset(expected[row], ' ', 16);
+    for (uint8_t col = row; col < 16; col += 2) {
+      expected[row][col] = 'A' + col;
+      gdm1602a_fb_set(&hlcd, row, col, expected[row][col]);
+    }
+  }
+
+  HOST_CHECK(gdm1602a_fb_flush_async(&hlcd));
+  complete_refresh();
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE1_START, expected[0]));
+  HOST_CHECK(lcd_row_is(GDM1602A_LINE2_START, expected[1]));
+  HOST_CHECK(lcd.cgram[7 * 8] == 8);
+  HOST_CHECK(hlcd.glyph_pending == 0);
+}
+
+/* Displays larger than LCD_DMA_MAX_ROWS x LCD_DMA_MAX_COLS are refused */
+static void test_geometry_limit(void) {
+  setup();
+  gdm1602a_init(&hlcd, &pins, GDM1602A_GEOMETRY_20X4);
+
+  gdm1602a_fb_write(&hlcd, 3, 0, "Too big");
+  HOST_CHECK(!gdm1602a_fb_flush_async(&hlcd));
+  HOST_CHECK(!gdm1602a_refresh_busy());
+  HOST_CHECK(host_dma_length == 0);
+
+  // The synchronous flush still serves it
+  HOST_CHECK(gdm1602a_fb_flush(&hlcd) == HAL_OK);
+  HOST_CHECK(lcd_row_is(0x54, "Too big"));
+}
+
+/* DB7 moved to a second port, seen by a GPIO hook instead of the model */
+static GPIO_TypeDef other_port;
+static bool db7_set;
+static bool gpioc_db7_set;
+
+static void split_pins_changed(GPIO_TypeDef *port) {
+  db7_set |= (other_port.ODR & GPIO_PIN_11) != 0;
+  gpioc_db7_set |= (host_gpioc.ODR & GPIO_PIN_11) != 0;
+}
+
+/* A pin map whose data pins do not share a port is driven pin by pin */
+static void test_split_data_port(void) {
+  GDM1602A_PinMapTypeDef split = pins;
+
+  setup();
+  memset(&other_port, 0, sizeof(other_port));
+  split.db[GDM1602A_DB4 + 3].port = &other_port;
+  split.db[GDM1602A_DB4 + 3].pin = GPIO_PIN_11;
+
+  gdm1602a_init(&hlcd, &split, GDM1602A_GEOMETRY_16X2);
+  HOST_CHECK(!hlcd.same_port);
+
+  db7_set = false;
+  gpioc_db7_set = false;
+  host_gpio_hook = split_pins_changed;
+
+  // Set DDRAM address instruction, DB7 high
+  HOST_CHECK(gdm1602a_set_cursor(&hlcd, 1, 0) == HAL_OK);
+  HOST_CHECK(db7_set);
+  HOST_CHECK(!gpioc_db7_set);
+
+  // The BSRR word stream can not drive two ports
+  gdm1602a_fb_write(&hlcd, 0, 0, "Split");
+  HOST_CHECK(!gdm1602a_fb_flush_async(&hlcd));
+  HOST_CHECK(!gdm1602a_refresh_busy());
+
+  gdm1602a_init(&hlcd, &pins, GDM1602A_GEOMETRY_16X2);
+  HOST_CHECK(hlcd.same_port);
+}
+
+int main(void) {
+  test_replay();
+  test_sync_busy();
+  test_framebuffer_changed_during_refresh();
+  test_start_failure();
+  test_transfer_error();
+  test_glyph_during_refresh();
+  test_worst_case();
+  test_geometry_limit();
+  test_split_data_port();
+
+  return HOST_RESULT();
+}
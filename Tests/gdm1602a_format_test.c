@@ -0,0 +1,170 @@
+#include "gdm1602a.h"
+#include "hal_host.h"
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+/* gdm1602a_printf against the vsnprintf version it replaced: same text in
+ * the framebuffer, then time per call and stack depth of both */
+
+#define ITERATIONS 200000
+#define PROBE_STACK_SIZE 32768
+#define PAINT 0xA5
+
+static const GDM1602A_PinMapTypeDef pins = LCD_PIN_MAP_DEFAULT;
+
+static GDM1602A_HandleTypeDef hlcd;
+
+/* The replaced implementation, formatted text written to the same cells */
+static HAL_StatusTypeDef vsnprintf_printf(GDM1602A_HandleTypeDef *hlcd,
+                                          uint8_t row, uint8_t col,
+                                          const char *format, ...) {
+  char buffer[GDM1602A_MAX_COLS + 1];
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(buffer, (size_t)(hlcd->cols - col) + 1, format, args);
+  va_end(args);
+
+  gdm1602a_fb_write(hlcd, row, col, buffer);
+  return gdm1602a_fb_flush(hlcd);
+}
+
+static void blank_row(void) {
+  memset(hlcd.framebuffer, ' ', hlcd.cols);
+}
+
+static bool row_is(const char *expected) {
+  char row[GDM1602A_MAX_COLS];
+
+  memset(row, ' ', sizeof(row));
+  memcpy(row, expected, strlen(expected));
+  return memcmp(hlcd.framebuffer, row, hlcd.cols) == 0;
+}
+
+#define CHECK_FORMAT(expected, ...)                                            \
+  do {                                                                         \
+    blank_row();                                                               \
+    HOST_CHECK(gdm1602a_printf(&hlcd, 0, 0, __VA_ARGS__) == HAL_OK);           \
+    HOST_CHECK(row_is(expected));                                              \
+    blank_row();                                                               \
+    vsnprintf_printf(&hlcd, 0, 0, __VA_ARGS__);                                \
+    HOST_CHECK(row_is(expected));                                              \
+  } while (0)
+
+static void test_conversions(void) {
+  const char *null_text = NULL;
+
+  CHECK_FORMAT("0 42 -42", "%d %i %d", 0, 42, -42);
+  CHECK_FORMAT("-2147483648 2147483647", "%d %d", (int32_t)INT32_MIN,
+               (int32_t)INT32_MAX);
+  CHECK_FORMAT("4294967295", "%u", (uint32_t)UINT32_MAX);
+  CHECK_FORMAT("beef BEEF 0000BEEF", "%x %X %08X", 0xBEEFu, 0xBEEFu, 0xBEEFu);
+  CHECK_FORMAT("  -42|-42  |-0042", "%5d|%-5d|%05d", -42, -42, -42);
+  CHECK_FORMAT("A text  |  text|100%", "%c %-6s|%6s|%d%%", 'A', "text",
+               "text", 100);
+  CHECK_FORMAT("1234567", "%ld", 1234567L);
+  CHECK_FORMAT("(null)", "%s", null_text);
+
+  // Line clipped at the last column
+  CHECK_FORMAT("0123456789012345678901234567890123456789", "%s%s",
+               "01234567890123456789", "0123456789012345678901234567890");
+}
+
+/* %.Nf reads an integer scaled by 10^N, vsnprintf needs the real value */
+static void test_fixed_point(void) {
+  blank_row();
+  gdm1602a_printf(&hlcd, 0, 0, "%.2f %.2f %.1f %.3f", 2345, -5, 0, 1);
+  HOST_CHECK(row_is("23.45 -0.05 0.0 0.001"));
+
+  blank_row();
+  vsnprintf_printf(&hlcd, 0, 0, "%.2f %.2f %.1f %.3f", 23.45, -0.05, 0.0,
+                   0.001);
+  HOST_CHECK(row_is("23.45 -0.05 0.0 0.001"));
+
+  blank_row();
+  gdm1602a_printf(&hlcd, 0, 0, "T: %6.2f C", 2508);
+  HOST_CHECK(row_is("T:  25.08 C"));
+}
+
+/* Typical status line, the cells do not change after the first call */
+static void format_lcd(void) {
+  gdm1602a_printf(&hlcd, 1, 0, "T%3d.%02u P%6lu %4X", 25, 8u, 100653ul,
+                  0x1Fu);
+}
+
+static void format_vsnprintf(void) {
+  vsnprintf_printf(&hlcd, 1, 0, "T%3d.%02u P%6lu %4X", 25, 8u, 100653ul,
+                   0x1Fu);
+}
+
+static double ns_per_call(void (*format)(void)) {
+  struct timespec start, end;
+
+  format();
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < ITERATIONS; i++) {
+    format();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) /
+         ITERATIONS;
+}
+
+/* Run format on a painted stack and measure how deep it wrote */
+static uint8_t probe_stack[PROBE_STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t probe_context, main_context;
+static void (*probe_format)(void);
+
+static void probe_entry(void) { probe_format(); }
+
+static uint32_t stack_depth(void (*format)(void)) {
+  uint32_t unused = 0;
+
+  memset(probe_stack, PAINT, sizeof(probe_stack));
+  probe_format = format;
+
+  getcontext(&probe_context);
+  probe_context.uc_stack.ss_sp = probe_stack;
+  probe_context.uc_stack.ss_size = sizeof(probe_stack);
+  probe_context.uc_link = &main_context;
+  makecontext(&probe_context, probe_entry, 0);
+  swapcontext(&main_context, &probe_context);
+
+  while (unused < sizeof(probe_stack) && probe_stack[unused] == PAINT) {
+    unused++;
+  }
+
+  return sizeof(probe_stack) - unused;
+}
+
+static void test_benchmark(void) {
+  uint32_t lcd_stack, vsnprintf_stack;
+  double lcd_ns, vsnprintf_ns;
+
+  format_lcd();
+  lcd_ns = ns_per_call(format_lcd);
+  vsnprintf_ns = ns_per_call(format_vsnprintf);
+  lcd_stack = stack_depth(format_lcd);
+  vsnprintf_stack = stack_depth(format_vsnprintf);
+
+  HOST_CHECK(lcd_stack < vsnprintf_stack);
+
+  printf("gdm1602a_printf: %.0f ns/call, %u bytes of stack\n", lcd_ns,
+         (unsigned)lcd_stack);
+  printf("vsnprintf:       %.0f ns/call, %u bytes of stack\n", vsnprintf_ns,
+         (unsigned)vsnprintf_stack);
+}
+
+int main(void) {
+  memset(&host_gpioc, 0, sizeof(host_gpioc));
+  gdm1602a_init(&hlcd, &pins, GDM1602A_GEOMETRY_40X2);
+
+  test_conversions();
+  test_fixed_point();
+  test_benchmark();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,114 @@
+#include "gdm1602a.h"
+#include "hal_host.h"
+#include "hd44780_model.h"
+#include <string.h>
+
+/* CGRAM glyph cache eviction, checked against the CGRAM of the HD44780 model
+ * on the default 4-bit pin-by-pin bus */
+
+#define GLYPHS (GDM1602A_CGRAM_SLOTS + 1)
+
+static const GDM1602A_PinMapTypeDef pins = LCD_PIN_MAP_DEFAULT;
+
+static GDM1602A_HandleTypeDef hlcd;
+static HostHD44780TypeDef lcd;
+static uint8_t bitmaps[GLYPHS][GDM1602A_GLYPH_ROWS];
+
+static void setup(void) {
+  uint16_t db[8];
+
+  for (uint8_t i = 0; i < 8; i++) {
+    db[i] = pins.db[i].pin;
+  }
+
+  // Glyph n has every row set to n + 1
+  for (uint8_t n = 0; n < GLYPHS; n++) {
+    memset(bitmaps[n], n + 1, GDM1602A_GLYPH_ROWS);
+  }
+
+  memset(&host_gpioc, 0, sizeof(host_gpioc));
+  host_hd44780_init(&lcd, GPIOC, pins.rs.pin, 0, pins.e.pin, db);
+  gdm1602a_init(&hlcd, &pins, GDM1602A_GEOMETRY_16X2);
+}
+
+static bool cgram_holds(uint8_t slot, uint8_t glyph) {
+  return memcmp(&lcd.cgram[slot * GDM1602A_GLYPH_ROWS], bitmaps[glyph],
+                GDM1602A_GLYPH_ROWS) == 0;
+}
+
+static void load_all_slots(void) {
+  for (uint8_t n = 0; n < GDM1602A_CGRAM_SLOTS; n++) {
+    HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[n]) == n);
+    HOST_CHECK(cgram_holds(n, n));
+  }
+}
+
+static void test_cache_hit(void) {
+  uint32_t instructions;
+
+  setup();
+  load_all_slots();
+
+  instructions = lcd.instructions;
+  HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[3]) == 3);
+  HOST_CHECK(lcd.instructions == instructions);
+}
+
+/* Slot 0 idles while the others are used. On a 16-bit clock its age wrapped
+ * to less than theirs and a recently used slot was evicted instead */
+static void test_long_idle_slot(void) {
+  setup();
+  load_all_slots();
+
+  for (uint32_t i = 0; i < 0x10000 - 3; i++) {
+    gdm1602a_glyph(&hlcd, bitmaps[1 + i % (GDM1602A_CGRAM_SLOTS - 1)]);
+  }
+
+  HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[GLYPHS - 1]) == 0);
+  HOST_CHECK(cgram_holds(0, GLYPHS - 1));
+  HOST_CHECK(!lcd.cgram_mode);
+}
+
+/* Stamps taken on both sides of the clock wrapping around */
+static void test_clock_wrap(void) {
+  setup();
+  hlcd.glyph_clock = UINT32_MAX - 3;
+  load_all_slots();
+
+  // Slot 0 becomes the most recent, slot 1 the least
+  HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[0]) == 0);
+  HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[GLYPHS - 1]) == 1);
+  HOST_CHECK(cgram_holds(0, 0));
+  HOST_CHECK(cgram_holds(1, GLYPHS - 1));
+}
+
+/* Slots shown in the framebuffer are evicted last */
+static void test_visible_slot_kept(void) {
+  setup();
+  load_all_slots();
+
+  gdm1602a_fb_set(&hlcd, 0, 0, 0);
+  HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[GLYPHS - 1]) == 1);
+  HOST_CHECK(cgram_holds(0, 0));
+}
+
+/* Code 8 + n shows slot n as well, the slot must not be evicted */
+static void test_alias_code_kept(void) {
+  setup();
+  load_all_slots();
+
+  gdm1602a_fb_set(&hlcd, 1, 15, GDM1602A_CGRAM_SLOTS + 0);
+  HOST_CHECK(gdm1602a_fb_flush(&hlcd) == HAL_OK);
+  HOST_CHECK(gdm1602a_glyph(&hlcd, bitmaps[GLYPHS - 1]) == 1);
+  HOST_CHECK(cgram_holds(0, 0));
+}
+
+int main(void) {
+  test_cache_hit();
+  test_long_idle_slot();
+  test_clock_wrap();
+  test_visible_slot_kept();
+  test_alias_code_kept();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,118 @@
+#include "gdm1602a.h"
+#include "gdm1602a_test.h"
+#include "hal_host.h"
+#include "hd44780_model.h"
+#include <string.h>
+
+/* The nine on-target scenarios of gdm1602a_test.c against the HD44780 model:
+ * DDRAM, CGRAM and display state they leave behind, no timing violations,
+ * and bus time between the controller's execution time and twice that */
+
+#define TEST_DISPLAY_CONTROL 0x04 // Display on, cursor off, blink off
+#define TEST_CURSOR_MOVEMENT 3
+#define TEST_CURSOR_ADDRESS 0x41 // Back at row 1, column 1
+#define TEST_CUSTOM_CHARS 5
+
+static const GDM1602A_PinMapTypeDef pins = LCD_PIN_MAP_DEFAULT;
+
+static GDM1602A_HandleTypeDef hlcd;
+static HostHD44780TypeDef lcd;
+
+/* Bitmaps test 6 loads into CGRAM 0-5 */
+static const uint8_t custom_chars[][GDM1602A_GLYPH_ROWS] = {
+    {0x00, 0x0A, 0x1F, 0x1F, 0x1F, 0x0E, 0x04, 0x00},
+    {0x00, 0x0A, 0x0A, 0x00, 0x11, 0x0E, 0x00, 0x00},
+    {0x04, 0x0E, 0x0E, 0x0E, 0x1F, 0x00, 0x04, 0x00},
+    {0x04, 0x0E, 0x1F, 0x04, 0x04, 0x04, 0x04, 0x00},
+    {0x04, 0x04, 0x04, 0x04, 0x1F, 0x0E, 0x04, 0x00},
+    {0x0E, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F}};
+
+static void setup(void) {
+  uint16_t db[8];
+
+  for (uint8_t i = 0; i < 8; i++) {
+    db[i] = pins.db[i].pin;
+  }
+
+  memset(&host_gpioc, 0, sizeof(host_gpioc));
+#if LCD_USE_RW_PIN
+  host_hd44780_init(&lcd, GPIOC, pins.rs.pin, pins.rw.pin, pins.e.pin, db);
+#else
+  host_hd44780_init(&lcd, GPIOC, pins.rs.pin, 0, pins.e.pin, db);
+#endif
+  gdm1602a_init(&hlcd, &pins, GDM1602A_GEOMETRY_16X2);
+}
+
+static bool ddram_holds(uint8_t test) {
+  char row[TEST_COLS];
+
+  for (uint8_t r = 0; r < TEST_ROWS; r++) {
+    host_hd44780_row(&lcd, hlcd.row_offset[r], TEST_COLS, row);
+
+    if (memcmp(row, gdm1602a_test_get_expected(test, r), TEST_COLS) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void test_init(void) {
+  HOST_CHECK(lcd.violations == 0);
+  HOST_CHECK(lcd.four_bit == !LCD_USE_8BIT_MODE);
+  HOST_CHECK(lcd.function & 0x08); // 2 lines
+  HOST_CHECK(lcd.display_control == TEST_DISPLAY_CONTROL);
+}
+
+static void test_scenario(uint8_t test) {
+  uint32_t bus_us;
+#if LCD_USE_RW_PIN
+  uint32_t reads;
+#endif
+
+  hlcd.bus_cycles = 0;
+  lcd.exec_us = 0;
+
+  gdm1602a_test_run_single(&hlcd, test);
+  bus_us = hlcd.bus_cycles / (SystemCoreClock / 1000000);
+
+  printf("%-16s bus %7lu us, HD44780 %7lu us\n", gdm1602a_test_get_name(test),
+         (unsigned long)bus_us, (unsigned long)lcd.exec_us);
+
+  HOST_CHECK(ddram_holds(test));
+  HOST_CHECK(lcd.display_control == TEST_DISPLAY_CONTROL);
+  HOST_CHECK(lcd.shift == 0);
+  HOST_CHECK(lcd.violations == 0);
+  HOST_CHECK(bus_us >= lcd.exec_us);
+  HOST_CHECK(bus_us <= 2 * lcd.exec_us);
+
+  if (test == TEST_CURSOR_MOVEMENT) {
+    HOST_CHECK(!lcd.cgram_mode && lcd.ac == TEST_CURSOR_ADDRESS);
+  }
+
+  if (test == TEST_CUSTOM_CHARS) {
+    HOST_CHECK(memcmp(lcd.cgram, custom_chars, sizeof(custom_chars)) == 0);
+  }
+
+#if LCD_USE_RW_PIN
+  // On-target check, reads DDRAM back through the driver
+  reads = lcd.reads;
+
+  HOST_CHECK(gdm1602a_test_verify(&hlcd, test));
+  HOST_CHECK(
+      !gdm1602a_test_verify(&hlcd, (test + 1) % gdm1602a_test_get_count()));
+  HOST_CHECK(lcd.reads > reads);
+  HOST_CHECK(lcd.violations == 0);
+#endif
+}
+
+int main(void) {
+  setup();
+  test_init();
+
+  for (uint8_t test = 0; test < gdm1602a_test_get_count(); test++) {
+    test_scenario(test);
+  }
+
+  return HOST_RESULT();
+}
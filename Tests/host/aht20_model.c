@@ -0,0 +1,81 @@
+#include "aht20_model.h"
+#include "aht20.h"
+#include <string.h>
+
+static uint8_t aht20_status(HostAHT20TypeDef *aht) {
+  uint8_t status = aht->calibrated ? AHT20_STATUS_CAL_BIT : 0;
+
+  if (aht->measuring && !aht->stuck &&
+      (int32_t)(host_tick - aht->measurement_end) >= 0) {
+    aht->measuring = 0;
+    aht->measurements++;
+  }
+
+  if (aht->measuring) {
+    status |= AHT20_STATUS_BUSY_BIT;
+  }
+
+  return status;
+}
+
+static void aht20_transmit(HostI2CDeviceTypeDef *dev, const uint8_t *data,
+                           uint16_t size) {
+  HostAHT20TypeDef *aht = (HostAHT20TypeDef *)dev;
+
+  switch (data[0]) {
+  case AHT20_CMD_INIT:
+    aht->calibrated = 1;
+    break;
+  case AHT20_CMD_TRIG_MEAS:
+    aht->measuring = 1;
+    aht->measurement_end = host_tick + aht->measure_ms;
+    break;
+  case AHT20_CMD_SOFT_RESET:
+    aht->measuring = 0;
+    break;
+  default:
+    break;
+  }
+}
+
+static void aht20_receive(HostI2CDeviceTypeDef *dev, uint8_t *data,
+                          uint16_t size) {
+  HostAHT20TypeDef *aht = (HostAHT20TypeDef *)dev;
+  uint8_t frame[AHT20_FRAME_SIZE_CRC];
+
+  frame[0] = aht20_status(aht);
+  frame[1] = (uint8_t)(aht->raw_humidity >> 12);
+  frame[2] = (uint8_t)(aht->raw_humidity >> 4);
+  frame[3] = (uint8_t)((aht->raw_humidity << 4) |
+                       ((aht->raw_temperature >> 16) & 0x0F));
+  frame[4] = (uint8_t)(aht->raw_temperature >> 8);
+  frame[5] = (uint8_t)aht->raw_temperature;
+  frame[6] = AHT20_Crc8(frame, AHT20_FRAME_SIZE);
+
+  if (aht->corrupt_frames > 0) {
+    frame[1] ^= 0x01;
+    aht->corrupt_frames--;
+  }
+
+  aht->frame_size = size;
+  aht->frame_reads++;
+
+  memcpy(data, frame, size < sizeof(frame) ? size : sizeof(frame));
+}
+
+static void aht20_mem_read(HostI2CDeviceTypeDef *dev, uint16_t reg,
+                           uint16_t size) {
+  dev->regs[AHT20_REG_STATUS] = aht20_status((HostAHT20TypeDef *)dev);
+}
+
+void host_aht20_init(HostAHT20TypeDef *aht, uint16_t address) {
+  memset(aht, 0, sizeof(*aht));
+
+  aht->i2c.address = address;
+  aht->i2c.transmit = aht20_transmit;
+  aht->i2c.receive = aht20_receive;
+  aht->i2c.mem_read = aht20_mem_read;
+  aht->raw_humidity = HOST_AHT20_RAW_HUMIDITY;
+  aht->raw_temperature = HOST_AHT20_RAW_TEMPERATURE;
+  aht->measure_ms = 75; // Typical, AHT20_MEASURE_DELAY is the maximum
+}
@@ -0,0 +1,34 @@
+#ifndef AHT20_MODEL_H
+#define AHT20_MODEL_H
+
+#include "hal_host.h"
+
+/* AHT20 stand-in on the host I2C bus. A triggered measurement keeps the busy
+ * bit set for measure_ms, then the frame carries raw_humidity and
+ * raw_temperature with a valid CRC byte. corrupt_frames flips a humidity bit
+ * after the CRC was computed, like a disturbed bus */
+typedef struct {
+  HostI2CDeviceTypeDef i2c; // Must stay first
+
+  uint32_t raw_humidity;    // 20-bit S_RH
+  uint32_t raw_temperature; // 20-bit S_T
+  uint32_t measure_ms;
+
+  uint8_t calibrated;
+  uint8_t stuck; // Keep the busy bit set forever
+  uint32_t measurement_end;
+  uint8_t measuring;
+  uint32_t measurements;
+
+  uint32_t corrupt_frames; // Next frames read with a flipped bit
+  uint16_t frame_size;     // Bytes of the last frame read
+  uint32_t frame_reads;
+} HostAHT20TypeDef;
+
+/* 50 %RH and 25 degC */
+#define HOST_AHT20_RAW_HUMIDITY 0x80000
+#define HOST_AHT20_RAW_TEMPERATURE 0x60000
+
+void host_aht20_init(HostAHT20TypeDef *aht, uint16_t address);
+
+#endif
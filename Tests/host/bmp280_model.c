@@ -0,0 +1,121 @@
+#include "bmp280_model.h"
+#include "bmp280.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Calibration example from the datasheet, section 3.12 */
+static const int32_t calibration[12] = {27504, 26435, -1000, 36477,
+                                        -10685, 3024, 2855, 140,
+                                        -7, 15500, -14600, 6000};
+
+static void write_raw(uint8_t *regs, int32_t adc) {
+  regs[0] = (uint8_t)(adc >> 12);
+  regs[1] = (uint8_t)(adc >> 4);
+  regs[2] = (uint8_t)(adc << 4);
+}
+
+static int32_t read_raw(const uint8_t *regs) {
+  return ((int32_t)regs[0] << 12) | ((int32_t)regs[1] << 4) | (regs[2] >> 4);
+}
+
+static uint32_t samples(uint8_t osrs) {
+  if (osrs == BMP280_OVERSAMPLING_SKIP) {
+    return 0;
+  }
+
+  return osrs >= BMP280_OVERSAMPLING_16X ? 16 : 1U << (osrs - 1);
+}
+
+/* Datasheet maximum measurement time rounded up to whole ticks */
+static uint32_t conversion_ms(uint8_t ctrl_meas) {
+  uint32_t osrs_t = samples(ctrl_meas >> 5);
+  uint32_t osrs_p = samples((ctrl_meas >> 2) & 0x07);
+  uint32_t time_us = 1250 + 2300 * osrs_t;
+
+  if (osrs_p != 0) {
+    time_us += 2300 * osrs_p + 575;
+  }
+
+  return (time_us + 999) / 1000;
+}
+
+/* Latch the conversion result into the data registers */
+static void finish_conversion(HostBMP280TypeDef *bmp) {
+  uint8_t ctrl_meas = bmp->i2c.regs[BMP280_REG_CTRL_MEAS];
+  bool temperature = (ctrl_meas >> 5) != BMP280_OVERSAMPLING_SKIP;
+  bool pressure = ((ctrl_meas >> 2) & 0x07) != BMP280_OVERSAMPLING_SKIP;
+
+  write_raw(&bmp->i2c.regs[BMP280_REG_TEMP_MSB],
+            temperature ? bmp->adc_T : HOST_BMP280_SKIPPED);
+  write_raw(&bmp->i2c.regs[BMP280_REG_PRESS_MSB],
+            pressure ? bmp->adc_P : HOST_BMP280_SKIPPED);
+
+  bmp->i2c.regs[BMP280_REG_STATUS] &= ~BMP280_STATUS_MEASURING_BIT;
+  bmp->conversions++;
+}
+
+static void bmp280_mem_write(HostI2CDeviceTypeDef *dev, uint16_t reg,
+                             uint16_t size) {
+  HostBMP280TypeDef *bmp = (HostBMP280TypeDef *)dev;
+  uint8_t ctrl_meas = dev->regs[BMP280_REG_CTRL_MEAS];
+
+  if (reg != BMP280_REG_CTRL_MEAS || (ctrl_meas & 0x03) == 0) {
+    return;
+  }
+
+  dev->regs[BMP280_REG_STATUS] |= BMP280_STATUS_MEASURING_BIT;
+  bmp->conversion_end = host_tick + conversion_ms(ctrl_meas);
+
+  // Forced mode returns to sleep, normal mode keeps converting
+  if ((ctrl_meas & 0x03) == BMP280_MODE_FORCED) {
+    dev->regs[BMP280_REG_CTRL_MEAS] &= ~0x03;
+  }
+}
+
+static void bmp280_mem_read(HostI2CDeviceTypeDef *dev, uint16_t reg,
+                            uint16_t size) {
+  HostBMP280TypeDef *bmp = (HostBMP280TypeDef *)dev;
+
+  if (reg < BMP280_REG_TRIMM_PARAM + BMP280_TRIMM_PARAM_REGISTERS_COUNT &&
+      reg + size > BMP280_REG_TRIMM_PARAM) {
+    bmp->trimming_reads++;
+  }
+
+  if (bmp->stuck || !(dev->regs[BMP280_REG_STATUS] &
+                      BMP280_STATUS_MEASURING_BIT)) {
+    return;
+  }
+
+  if ((int32_t)(host_tick - bmp->conversion_end) >= 0) {
+    finish_conversion(bmp);
+  }
+}
+
+void host_bmp280_init(HostBMP280TypeDef *bmp, uint16_t address) {
+  memset(bmp, 0, sizeof(*bmp));
+
+  bmp->i2c.address = address;
+  bmp->i2c.mem_write = bmp280_mem_write;
+  bmp->i2c.mem_read = bmp280_mem_read;
+  bmp->adc_T = HOST_BMP280_ADC_T;
+  bmp->adc_P = HOST_BMP280_ADC_P;
+
+  bmp->i2c.regs[BMP280_REG_CHIP_ID] = BMP280_CHIP_ID;
+
+  for (int i = 0; i < 12; i++) {
+    bmp->i2c.regs[BMP280_REG_TRIMM_PARAM + 2 * i] = (uint8_t)calibration[i];
+    bmp->i2c.regs[BMP280_REG_TRIMM_PARAM + 2 * i + 1] =
+        (uint8_t)(calibration[i] >> 8);
+  }
+
+  write_raw(&bmp->i2c.regs[BMP280_REG_TEMP_MSB], HOST_BMP280_SKIPPED);
+  write_raw(&bmp->i2c.regs[BMP280_REG_PRESS_MSB], HOST_BMP280_SKIPPED);
+}
+
+int32_t host_bmp280_raw_temperature(const HostBMP280TypeDef *bmp) {
+  return read_raw(&bmp->i2c.regs[BMP280_REG_TEMP_MSB]);
+}
+
+int32_t host_bmp280_raw_pressure(const HostBMP280TypeDef *bmp) {
+  return read_raw(&bmp->i2c.regs[BMP280_REG_PRESS_MSB]);
+}
@@ -0,0 +1,31 @@
+#ifndef BMP280_MODEL_H
+#define BMP280_MODEL_H
+
+#include "hal_host.h"
+
+/* BMP280 stand-in on the host I2C bus. Forced conversions keep the measuring
+ * bit set for the datasheet maximum time of the written oversampling, skipped
+ * conversions read back as 0x80000 like on the chip */
+typedef struct {
+  HostI2CDeviceTypeDef i2c; // Must stay first
+
+  /* Raw result of the next conversion */
+  int32_t adc_T;
+  int32_t adc_P;
+
+  uint32_t conversion_end; // host_tick when the running conversion is done
+  uint32_t conversions;
+  uint32_t trimming_reads; // Reads touching registers 0x88..0x9F
+  uint8_t stuck; // Keep the measuring bit set forever
+} HostBMP280TypeDef;
+
+/* Raw values of the datasheet example, 25.08 degC and 100653 Pa */
+#define HOST_BMP280_ADC_T 519888
+#define HOST_BMP280_ADC_P 415148
+#define HOST_BMP280_SKIPPED 0x80000
+
+void host_bmp280_init(HostBMP280TypeDef *bmp, uint16_t address);
+int32_t host_bmp280_raw_temperature(const HostBMP280TypeDef *bmp);
+int32_t host_bmp280_raw_pressure(const HostBMP280TypeDef *bmp);
+
+#endif
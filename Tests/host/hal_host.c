@@ -0,0 +1,338 @@
+#include "hal_host.h"
+#include "delay_us.h"
+#include <stddef.h>
+#include <string.h>
+
+#define HOST_I2C_MAX_DEVICES 4
+
+int host_failures = 0;
+uint32_t host_tick = 0;
+uint32_t host_busy_wait_calls = 0;
+uint32_t host_busy_wait_max_ms = 0;
+uint32_t host_adc_value = 0;
+
+uint32_t SystemCoreClock = 80000000;
+
+uint8_t *host_flash_page = NULL;
+HAL_StatusTypeDef host_flash_unlock_status = HAL_OK;
+FLASH_EraseInitTypeDef host_flash_erase;
+uint32_t host_flash_stale_errors = 0;
+
+uint64_t host_us = 0;
+
+GPIO_TypeDef host_gpioc;
+RCC_TypeDef host_rcc;
+TIM_TypeDef host_tim6;
+DWT_Type host_dwt;
+FLASH_TypeDef host_flash;
+SYSCFG_TypeDef host_syscfg;
+
+void (*host_gpio_hook)(GPIO_TypeDef *port) = NULL;
+
+DMA_HandleTypeDef *host_dma = NULL;
+uint32_t host_dma_src = 0;
+uint32_t host_dma_dst = 0;
+uint32_t host_dma_length = 0;
+HAL_StatusTypeDef host_dma_start_status = HAL_OK;
+bool host_dma_error = false;
+
+static HostI2CDeviceTypeDef *i2c_devices[HOST_I2C_MAX_DEVICES];
+
+void host_advance_us(uint32_t us) {
+  host_us += us;
+  host_dwt.CYCCNT += us * (SystemCoreClock / 1000000);
+}
+
+void host_advance_ms(uint32_t ms) {
+  host_tick += ms;
+  host_advance_us(ms * 1000);
+}
+
+void delay_us(uint32_t us) { host_advance_us(us); }
+
+uint32_t HAL_GetTick(void) { return host_tick; }
+
+HAL_TickFreqTypeDef HAL_GetTickFreq(void) { return HAL_TICK_FREQ_1KHZ; }
+
+void host_reset_busy_wait(void) {
+  host_busy_wait_calls = 0;
+  host_busy_wait_max_ms = 0;
+}
+
+void HAL_Delay(uint32_t Delay) {
+  host_busy_wait_calls++;
+  if (Delay > host_busy_wait_max_ms) {
+    host_busy_wait_max_ms = Delay;
+  }
+
+  host_advance_ms(Delay);
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry) {
+  // Wake up on the next tick
+  host_advance_ms(1);
+}
+
+/* ADC, conversions complete immediately */
+
+HAL_StatusTypeDef HAL_ADC_Start(ADC_HandleTypeDef *hadc) { return HAL_OK; }
+
+HAL_StatusTypeDef HAL_ADC_Stop(ADC_HandleTypeDef *hadc) { return HAL_OK; }
+
+HAL_StatusTypeDef HAL_ADC_PollForConversion(ADC_HandleTypeDef *hadc,
+                                            uint32_t Timeout) {
+  return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetValue(const ADC_HandleTypeDef *hadc) {
+  return host_adc_value;
+}
+
+/* I2C */
+
+void host_i2c_attach(HostI2CDeviceTypeDef *dev) {
+  for (int i = 0; i < HOST_I2C_MAX_DEVICES; i++) {
+    if (i2c_devices[i] == NULL) {
+      i2c_devices[i] = dev;
+      return;
+    }
+  }
+}
+
+void host_i2c_detach_all(void) { memset(i2c_devices, 0, sizeof(i2c_devices)); }
+
+static HostI2CDeviceTypeDef *host_i2c_find(uint16_t address) {
+  for (int i = 0; i < HOST_I2C_MAX_DEVICES; i++) {
+    if (i2c_devices[i] != NULL && i2c_devices[i]->address == address) {
+      i2c_devices[i]->transfers++;
+      return i2c_devices[i];
+    }
+  }
+
+  return NULL;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c,
+                                   uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, uint8_t *pData,
+                                   uint16_t Size, uint32_t Timeout) {
+  HostI2CDeviceTypeDef *dev = host_i2c_find(DevAddress);
+
+  if (dev == NULL) {
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    return HAL_ERROR;
+  }
+
+  if (dev->mem_read != NULL) {
+    dev->mem_read(dev, MemAddress, Size);
+  }
+
+  for (uint16_t i = 0; i < Size; i++) {
+    pData[i] = dev->regs[(MemAddress + i) & 0xFF];
+  }
+
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c,
+                                    uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData,
+                                    uint16_t Size, uint32_t Timeout) {
+  HostI2CDeviceTypeDef *dev = host_i2c_find(DevAddress);
+
+  if (dev == NULL) {
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    return HAL_ERROR;
+  }
+
+  for (uint16_t i = 0; i < Size; i++) {
+    dev->regs[(MemAddress + i) & 0xFF] = pData[i];
+  }
+
+  if (dev->mem_write != NULL) {
+    dev->mem_write(dev, MemAddress, Size);
+  }
+
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  return HAL_OK;
+}
+
+/* Non-blocking reads complete immediately */
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c,
+                                      uint16_t DevAddress, uint16_t MemAddress,
+                                      uint16_t MemAddSize, uint8_t *pData,
+                                      uint16_t Size) {
+  HAL_I2C_Mem_Read(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, 0);
+  hi2c->State = HAL_I2C_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c,
+                                       uint16_t DevAddress,
+                                       uint16_t MemAddress,
+                                       uint16_t MemAddSize, uint8_t *pData,
+                                       uint16_t Size) {
+  return HAL_I2C_Mem_Read_IT(hi2c, DevAddress, MemAddress, MemAddSize, pData,
+                             Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c,
+                                          uint16_t DevAddress, uint8_t *pData,
+                                          uint16_t Size, uint32_t Timeout) {
+  HostI2CDeviceTypeDef *dev = host_i2c_find(DevAddress);
+
+  if (dev == NULL) {
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    return HAL_ERROR;
+  }
+
+  if (dev->transmit != NULL) {
+    dev->transmit(dev, pData, Size);
+  }
+
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c,
+                                         uint16_t DevAddress, uint8_t *pData,
+                                         uint16_t Size, uint32_t Timeout) {
+  HostI2CDeviceTypeDef *dev = host_i2c_find(DevAddress);
+
+  if (dev == NULL) {
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    return HAL_ERROR;
+  }
+
+  if (dev->receive != NULL) {
+    dev->receive(dev, pData, Size);
+  } else {
+    memset(pData, 0, Size);
+  }
+
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  return HAL_OK;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(const I2C_HandleTypeDef *hi2c) {
+  return hi2c->State;
+}
+
+uint32_t HAL_I2C_GetError(const I2C_HandleTypeDef *hi2c) {
+  return hi2c->ErrorCode;
+}
+
+/* Flash */
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) { return host_flash_unlock_status; }
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) { return HAL_OK; }
+
+uint32_t HAL_FLASH_GetError(void) { return HAL_FLASH_ERROR_NONE; }
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit,
+                                    uint32_t *PageError) {
+  host_flash_erase = *pEraseInit;
+
+  // Error flags left set fail the operation like FLASH_WaitForLastOperation
+  if (host_flash_page == NULL ||
+      (host_flash_stale_errors & ~host_flash.SR) != 0) {
+    return HAL_ERROR;
+  }
+
+  memset(host_flash_page, 0xFF, FLASH_PAGE_SIZE);
+  *PageError = 0xFFFFFFFF;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address,
+                                    uint64_t Data) {
+  memcpy((void *)(uintptr_t)Address, &Data, sizeof(Data));
+  return HAL_OK;
+}
+
+/* GPIO */
+
+/* BSRR is write-only, fold a store into ODR like the port does, set wins */
+void host_gpio_sync(GPIO_TypeDef *port) {
+  uint32_t bsrr = port->BSRR;
+
+  if (bsrr == 0) {
+    return;
+  }
+
+  port->BSRR = 0;
+  port->ODR = (port->ODR & ~(bsrr >> 16)) | (bsrr & 0xFFFF);
+
+  if (host_gpio_hook != NULL) {
+    host_gpio_hook(port);
+  }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
+                       GPIO_PinState PinState) {
+  // A direct BSRR store since the last call lands first
+  host_gpio_sync(GPIOx);
+
+  if (PinState != GPIO_PIN_RESET) {
+    GPIOx->ODR |= GPIO_Pin;
+  } else {
+    GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+  }
+
+  if (host_gpio_hook != NULL) {
+    host_gpio_hook(GPIOx);
+  }
+}
+
+/* DMA, memory to peripheral word transfers into a GPIO register */
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) { return HAL_OK; }
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress,
+                                   uint32_t DstAddress, uint32_t DataLength) {
+  if (host_dma_start_status != HAL_OK) {
+    return host_dma_start_status;
+  }
+
+  host_dma = hdma;
+  host_dma_src = SrcAddress;
+  host_dma_dst = DstAddress;
+  host_dma_length = DataLength;
+  return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma) {
+  if (host_dma_error) {
+    if (hdma->XferErrorCallback != NULL) {
+      hdma->XferErrorCallback(hdma);
+    }
+  } else if (hdma->XferCpltCallback != NULL) {
+    hdma->XferCpltCallback(hdma);
+  }
+}
+
+/* Store the words of the last transfer one request apart */
+void host_dma_replay(uint32_t word_us) {
+  const uint32_t *words = (const uint32_t *)(uintptr_t)host_dma_src;
+  volatile uint32_t *dst = (volatile uint32_t *)(uintptr_t)host_dma_dst;
+  GPIO_TypeDef *port = (GPIO_TypeDef *)(uintptr_t)(host_dma_dst -
+                                                   offsetof(GPIO_TypeDef,
+                                                            BSRR));
+
+  for (uint32_t i = 0; i < host_dma_length; i++) {
+    host_advance_us(word_us);
+    *dst = words[i];
+    host_gpio_sync(port);
+  }
+}
+
+/* NVIC and RCC */
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority,
+                          uint32_t SubPriority) {}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) { return SystemCoreClock; }
@@ -0,0 +1,93 @@
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Minimal test reporting, a test passes when no check failed */
+extern int host_failures;
+
+#define HOST_CHECK(condition)                                                  \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);     \
+      host_failures++;                                                         \
+    }                                                                          \
+  } while (0)
+
+#define HOST_RESULT() (host_failures == 0 ? 0 : 1)
+
+/* Virtual SysTick, advanced only by HAL_Delay and host_advance_ms */
+extern uint32_t host_tick;
+
+/* HAL_Delay spins the core, so every call is recorded as a busy-wait */
+extern uint32_t host_busy_wait_calls;
+extern uint32_t host_busy_wait_max_ms;
+
+/* Conversion result returned by HAL_ADC_GetValue */
+extern uint32_t host_adc_value;
+
+/* I2C slave stand-in. Register accesses auto-increment over regs, the
+ * optional hooks add device behaviour on top */
+typedef struct HostI2CDevice HostI2CDeviceTypeDef;
+
+struct HostI2CDevice {
+  uint16_t address; // HAL (shifted) address
+  uint8_t regs[256];
+
+  /* Called after a register write and before a register read */
+  void (*mem_write)(HostI2CDeviceTypeDef *dev, uint16_t reg, uint16_t size);
+  void (*mem_read)(HostI2CDeviceTypeDef *dev, uint16_t reg, uint16_t size);
+
+  /* Transfers without register address */
+  void (*transmit)(HostI2CDeviceTypeDef *dev, const uint8_t *data,
+                   uint16_t size);
+  void (*receive)(HostI2CDeviceTypeDef *dev, uint8_t *data, uint16_t size);
+
+  uint32_t transfers;
+};
+
+/* RAM stand-in for the flash page erased by HAL_FLASHEx_Erase */
+extern uint8_t *host_flash_page;
+extern HAL_StatusTypeDef host_flash_unlock_status;
+
+/* Last page erase request. Error flags in host_flash_stale_errors make the
+ * erase fail until they are written to host_flash.SR (write 1 to clear) */
+extern FLASH_EraseInitTypeDef host_flash_erase;
+extern uint32_t host_flash_stale_errors;
+
+/* Microsecond clock, advanced by delay_us and host_advance_ms. DWT->CYCCNT
+ * follows it at SystemCoreClock */
+extern uint64_t host_us;
+
+/* RAM stand-ins for the registers drivers access directly, host main.h
+ * points GPIOC, RCC, TIM6, DWT, FLASH and SYSCFG at them */
+extern GPIO_TypeDef host_gpioc;
+extern RCC_TypeDef host_rcc;
+extern TIM_TypeDef host_tim6;
+extern DWT_Type host_dwt;
+extern FLASH_TypeDef host_flash;
+extern SYSCFG_TypeDef host_syscfg;
+
+/* Called after a GPIO output changed, e.g. to feed a device model */
+extern void (*host_gpio_hook)(GPIO_TypeDef *port);
+
+/* Last DMA transfer started with HAL_DMA_Start_IT. It only completes when the
+ * test calls host_dma_replay and the driver's IRQ handler */
+extern DMA_HandleTypeDef *host_dma;
+extern uint32_t host_dma_src;
+extern uint32_t host_dma_dst;
+extern uint32_t host_dma_length;
+extern HAL_StatusTypeDef host_dma_start_status;
+extern bool host_dma_error; // HAL_DMA_IRQHandler reports a transfer error
+
+void host_advance_ms(uint32_t ms);
+void host_advance_us(uint32_t us);
+void host_reset_busy_wait(void);
+void host_i2c_attach(HostI2CDeviceTypeDef *dev);
+void host_i2c_detach_all(void);
+void host_gpio_sync(GPIO_TypeDef *port);
+void host_dma_replay(uint32_t word_us);
+
+#endif
@@ -0,0 +1,320 @@
+#include "hd44780_model.h"
+#include <string.h>
+
+/* Instruction bits, highest set bit selects the instruction */
+#define INS_CLEAR 0x01
+#define INS_HOME 0x02
+#define INS_ENTRY_MODE 0x04
+#define INS_DISPLAY_CTRL 0x08
+#define INS_SHIFT 0x10
+#define INS_FUNCTION_SET 0x20
+#define INS_SET_CGRAM 0x40
+#define INS_SET_DDRAM 0x80
+
+#define EM_SHIFT 0x01
+#define EM_INCREMENT 0x02
+#define SHIFT_RIGHT 0x04
+#define SHIFT_DISPLAY 0x08
+#define FS_2LINE 0x08
+#define FS_8BIT 0x10
+#define BUSY_FLAG 0x80
+
+/* Execution times [us] */
+#define EXEC_US 37
+#define EXEC_CLEAR_HOME_US 1520
+#define POWER_ON_US 15000
+#define RESET_FIRST_US 4100 // After the first function set of the reset
+#define RESET_SECOND_US 100 // After the second one
+
+static HostHD44780TypeDef *attached;
+
+static bool two_line(const HostHD44780TypeDef *lcd) {
+  return (lcd->function & FS_2LINE) != 0;
+}
+
+static uint8_t line_length(const HostHD44780TypeDef *lcd) {
+  return two_line(lcd) ? 40 : 80;
+}
+
+static void address_step(HostHD44780TypeDef *lcd, bool increment) {
+  if (lcd->cgram_mode) {
+    lcd->ac = (lcd->ac + (increment ? 1 : -1)) & (HOST_HD44780_CGRAM_SIZE - 1);
+    return;
+  }
+
+  if (!two_line(lcd)) {
+    lcd->ac = increment ? (lcd->ac + 1) % 80 : (lcd->ac + 79) % 80;
+  } else if (increment) {
+    lcd->ac = (lcd->ac == 0x27) ? 0x40 : (lcd->ac == 0x67) ? 0x00 : lcd->ac + 1;
+  } else {
+    lcd->ac = (lcd->ac == 0x00) ? 0x67 : (lcd->ac == 0x40) ? 0x27 : lcd->ac - 1;
+  }
+}
+
+static void execute(HostHD44780TypeDef *lcd, uint32_t us) {
+  lcd->busy_until = host_us + us;
+  lcd->exec_us += us;
+}
+
+static void display_shift(HostHD44780TypeDef *lcd, bool left) {
+  uint8_t length = line_length(lcd);
+
+  lcd->shift = (lcd->shift + (left ? 1 : length - 1)) % length;
+}
+
+static void instruction(HostHD44780TypeDef *lcd, uint8_t ins) {
+  uint32_t us = EXEC_US;
+
+  lcd->instructions++;
+
+  if (ins & INS_SET_DDRAM) {
+    lcd->ac = ins & 0x7F;
+    lcd->cgram_mode = 0;
+  } else if (ins & INS_SET_CGRAM) {
+    lcd->ac = ins & 0x3F;
+    lcd->cgram_mode = 1;
+  } else if (ins & INS_FUNCTION_SET) {
+    lcd->function = ins & 0x1C;
+    lcd->four_bit = !(ins & FS_8BIT);
+    lcd->nibble_pending = 0;
+
+    if (lcd->reset_step < 2) {
+      us = (lcd->reset_step == 0) ? RESET_FIRST_US : RESET_SECOND_US;
+      lcd->reset_step++;
+    }
+  } else if (ins & INS_SHIFT) {
+    if (ins & SHIFT_DISPLAY) {
+      display_shift(lcd, !(ins & SHIFT_RIGHT));
+    } else {
+      address_step(lcd, ins & SHIFT_RIGHT);
+    }
+  } else if (ins & INS_DISPLAY_CTRL) {
+    lcd->display_control = ins & 0x07;
+  } else if (ins & INS_ENTRY_MODE) {
+    lcd->entry_mode = ins & 0x03;
+  } else if (ins & INS_HOME) {
+    lcd->ac = 0;
+    lcd->cgram_mode = 0;
+    lcd->shift = 0;
+    us = EXEC_CLEAR_HOME_US;
+  } else if (ins & INS_CLEAR) {
+    memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+    lcd->ac = 0;
+    lcd->cgram_mode = 0;
+    lcd->shift = 0;
+    lcd->entry_mode |= EM_INCREMENT;
+    us = EXEC_CLEAR_HOME_US;
+  }
+
+  execute(lcd, us);
+}
+
+static void data_write(HostHD44780TypeDef *lcd, uint8_t data) {
+  bool increment = (lcd->entry_mode & EM_INCREMENT) != 0;
+
+  lcd->data_writes++;
+
+  if (lcd->cgram_mode) {
+    lcd->cgram[lcd->ac] = data & 0x1F;
+  } else {
+    lcd->ddram[lcd->ac] = data;
+
+    if (lcd->entry_mode & EM_SHIFT) {
+      display_shift(lcd, increment);
+    }
+  }
+
+  address_step(lcd, increment);
+  execute(lcd, EXEC_US);
+}
+
+/* Busy flag and address counter, or the CGRAM/DDRAM byte at the counter */
+static uint8_t read_value(HostHD44780TypeDef *lcd, bool rs) {
+  if (!rs) {
+    return (host_us < lcd->busy_until ? BUSY_FLAG : 0) | lcd->ac;
+  }
+
+  if (host_us < lcd->busy_until) {
+    lcd->violations++;
+  }
+
+  return lcd->cgram_mode ? lcd->cgram[lcd->ac] : lcd->ddram[lcd->ac];
+}
+
+/* Data read done, the counter moves like after a write */
+static void data_read(HostHD44780TypeDef *lcd) {
+  lcd->reads++;
+  address_step(lcd, (lcd->entry_mode & EM_INCREMENT) != 0);
+  lcd->busy_until = host_us + EXEC_US;
+}
+
+/* Drive the 4 data lines starting at first with a nibble */
+static void drive_lines(HostHD44780TypeDef *lcd, uint8_t first,
+                        uint8_t nibble) {
+  for (uint8_t bit = 0; bit < 4; bit++) {
+    if (nibble & (1 << bit)) {
+      lcd->port->IDR |= lcd->db[first + bit];
+    } else {
+      lcd->port->IDR &= ~(uint32_t)lcd->db[first + bit];
+    }
+  }
+}
+
+/* E rising with RW high, the byte is fetched at the first (or only) pulse */
+static void read_drive(HostHD44780TypeDef *lcd) {
+  bool rs = (lcd->bus_lines & lcd->rs) != 0;
+  uint8_t value;
+
+  if (lcd->four_bit) {
+    if (!lcd->nibble_pending) {
+      lcd->high_nibble = read_value(lcd, rs);
+      drive_lines(lcd, 4, lcd->high_nibble >> 4);
+    } else {
+      drive_lines(lcd, 4, lcd->high_nibble & 0x0F);
+    }
+    return;
+  }
+
+  value = read_value(lcd, rs);
+  drive_lines(lcd, 4, value >> 4);
+  drive_lines(lcd, 0, value & 0x0F);
+}
+
+/* E falling with RW high */
+static void read_end(HostHD44780TypeDef *lcd) {
+  if (lcd->four_bit) {
+    lcd->nibble_pending = !lcd->nibble_pending;
+
+    if (lcd->nibble_pending) {
+      return;
+    }
+  }
+
+  if (lcd->bus_lines & lcd->rs) {
+    data_read(lcd);
+  }
+}
+
+static uint8_t read_lines(const HostHD44780TypeDef *lcd, uint8_t first) {
+  uint8_t value = 0;
+
+  for (uint8_t bit = 0; bit < 4; bit++) {
+    if (lcd->port->ODR & lcd->db[first + bit]) {
+      value |= 1 << bit;
+    }
+  }
+
+  return value;
+}
+
+static void latch(HostHD44780TypeDef *lcd) {
+  bool rs = (lcd->port->ODR & lcd->rs) != 0;
+  uint8_t value;
+
+  if (host_us < lcd->busy_until) {
+    lcd->violations++;
+  }
+
+  if (lcd->four_bit) {
+    if (!lcd->nibble_pending) {
+      lcd->high_nibble = read_lines(lcd, 4);
+      lcd->nibble_pending = 1;
+      return;
+    }
+
+    value = (uint8_t)(lcd->high_nibble << 4) | read_lines(lcd, 4);
+    lcd->nibble_pending = 0;
+  } else {
+    value = (uint8_t)(read_lines(lcd, 4) << 4) | read_lines(lcd, 0);
+  }
+
+  if (rs) {
+    data_write(lcd, value);
+  } else {
+    instruction(lcd, value);
+  }
+}
+
+static uint32_t bus_mask(const HostHD44780TypeDef *lcd) {
+  uint32_t mask = lcd->rs | lcd->rw;
+
+  for (uint8_t line = 0; line < 8; line++) {
+    mask |= lcd->db[line];
+  }
+
+  return mask;
+}
+
+static void pins_changed(GPIO_TypeDef *port) {
+  HostHD44780TypeDef *lcd = attached;
+  uint32_t lines;
+  uint8_t e_level;
+
+  if (lcd == NULL || port != lcd->port) {
+    return;
+  }
+
+  e_level = (port->ODR & lcd->e) != 0;
+  lines = port->ODR & bus_mask(lcd);
+
+  if (!lcd->e_level && e_level) {
+    // Enable cycle time
+    if (lcd->e_rise_us != 0 && host_us - lcd->e_rise_us < 1) {
+      lcd->violations++;
+    }
+
+    lcd->e_rise_us = host_us;
+    lcd->bus_lines = lines;
+
+    if (lines & lcd->rw) {
+      read_drive(lcd);
+    }
+  } else if (lcd->e_level && e_level && lines != lcd->bus_lines) {
+    // Setup or hold time
+    lcd->violations++;
+    lcd->bus_lines = lines;
+  } else if (lcd->e_level && !e_level) {
+    // Enable pulse width
+    if (host_us - lcd->e_rise_us < 1) {
+      lcd->violations++;
+    }
+
+    if (lcd->bus_lines & lcd->rw) {
+      read_end(lcd);
+    } else {
+      latch(lcd);
+    }
+  }
+
+  lcd->e_level = e_level;
+}
+
+/* Power-on state, attached to the GPIO hook */
+void host_hd44780_init(HostHD44780TypeDef *lcd, GPIO_TypeDef *port,
+                       uint16_t rs, uint16_t rw, uint16_t e,
+                       const uint16_t db[8]) {
+  memset(lcd, 0, sizeof(*lcd));
+  lcd->port = port;
+  lcd->rs = rs;
+  lcd->rw = rw;
+  lcd->e = e;
+  memcpy(lcd->db, db, sizeof(lcd->db));
+
+  // Internal reset: 8-bit, 1 line, display off, increment
+  memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+  lcd->function = FS_8BIT;
+  lcd->entry_mode = EM_INCREMENT;
+  lcd->e_level = (port->ODR & e) != 0;
+  lcd->busy_until = host_us + POWER_ON_US;
+
+  attached = lcd;
+  host_gpio_hook = pins_changed;
+}
+
+/* DDRAM content from address on, as stored (display shift not applied) */
+void host_hd44780_row(const HostHD44780TypeDef *lcd, uint8_t address,
+                      uint8_t length, char *buffer) {
+  for (uint8_t i = 0; i < length; i++) {
+    buffer[i] = (char)lcd->ddram[(address + i) & (HOST_HD44780_DDRAM_SIZE - 1)];
+  }
+}
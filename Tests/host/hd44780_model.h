@@ -0,0 +1,59 @@
+#ifndef HD44780_MODEL_H
+#define HD44780_MODEL_H
+
+#include "hal_host.h"
+
+/* HD44780 stand-in on host GPIO pins. Writes are latched on the falling edge
+ * of E, in 8-bit mode from power-on until a function set selects 4 bits, then
+ * as high and low nibble on DB4-DB7. With RW high the model drives IDR while
+ * E is high: busy flag and address counter for RS low, CGRAM/DDRAM data for
+ * RS high.
+ *
+ * Timing is checked against host_us with the execution times of the
+ * datasheet at 270 kHz. Writes while the controller is busy, E pulses and
+ * cycles shorter than 1 us and data lines changing while E is high count as
+ * violations */
+#define HOST_HD44780_DDRAM_SIZE 0x80 // Indexed by DDRAM address
+#define HOST_HD44780_CGRAM_SIZE 0x40
+
+typedef struct {
+  GPIO_TypeDef *port;
+  uint16_t rs;
+  uint16_t rw; // 0 if not wired
+  uint16_t e;
+  uint16_t db[8]; // 0 for lines not wired
+
+  uint8_t ddram[HOST_HD44780_DDRAM_SIZE];
+  uint8_t cgram[HOST_HD44780_CGRAM_SIZE];
+  uint8_t ac;         // Address counter
+  uint8_t cgram_mode; // ac addresses CGRAM
+  uint8_t entry_mode; // I/D and S bits
+  uint8_t display_control;
+  uint8_t function; // DL, N and F bits
+  uint8_t shift;    // Cells the display is shifted left by
+
+  uint8_t four_bit;
+  uint8_t nibble_pending; // High nibble latched, low nibble next
+  uint8_t high_nibble;
+  uint8_t e_level;
+  uint8_t reset_step; // Function sets seen, the first ones wait longer
+
+  uint64_t busy_until; // host_us the running instruction completes at
+  uint64_t e_rise_us;
+  uint32_t bus_lines; // RS, RW and data lines while E is high
+
+  uint32_t violations;
+  uint32_t exec_us; // Execution time of all writes, the bus time lower bound
+  uint32_t reads;
+
+  uint32_t instructions;
+  uint32_t data_writes;
+} HostHD44780TypeDef;
+
+void host_hd44780_init(HostHD44780TypeDef *lcd, GPIO_TypeDef *port,
+                       uint16_t rs, uint16_t rw, uint16_t e,
+                       const uint16_t db[8]);
+void host_hd44780_row(const HostHD44780TypeDef *lcd, uint8_t address,
+                      uint8_t length, char *buffer);
+
+#endif
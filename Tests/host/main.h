@@ -0,0 +1,48 @@
+#ifndef __MAIN_H
+#define __MAIN_H
+
+/* Host stand-in for Core/Inc/main.h. Registers the drivers access directly
+ * are redirected to RAM, the LCD is wired to port C */
+#include "hal_host.h"
+
+#undef GPIOC
+#define GPIOC (&host_gpioc)
+#undef RCC
+#define RCC (&host_rcc)
+#undef TIM6
+#define TIM6 (&host_tim6)
+#undef DWT
+#define DWT (&host_dwt)
+#undef FLASH
+#define FLASH (&host_flash)
+#undef SYSCFG
+#define SYSCFG (&host_syscfg)
+#undef FLASH_SIZE
+#define FLASH_SIZE 0x100000U // Read from the flash size register on the target
+
+void Error_Handler(void);
+
+#define LCD_DB0_Pin GPIO_PIN_0
+#define LCD_DB0_GPIO_Port GPIOC
+#define LCD_DB1_Pin GPIO_PIN_1
+#define LCD_DB1_GPIO_Port GPIOC
+#define LCD_DB2_Pin GPIO_PIN_2
+#define LCD_DB2_GPIO_Port GPIOC
+#define LCD_DB3_Pin GPIO_PIN_3
+#define LCD_DB3_GPIO_Port GPIOC
+#define LCD_DB4_Pin GPIO_PIN_4
+#define LCD_DB4_GPIO_Port GPIOC
+#define LCD_DB5_Pin GPIO_PIN_5
+#define LCD_DB5_GPIO_Port GPIOC
+#define LCD_DB6_Pin GPIO_PIN_6
+#define LCD_DB6_GPIO_Port GPIOC
+#define LCD_DB7_Pin GPIO_PIN_7
+#define LCD_DB7_GPIO_Port GPIOC
+#define LCD_RS_Pin GPIO_PIN_8
+#define LCD_RS_GPIO_Port GPIOC
+#define LCD_E_Pin GPIO_PIN_9
+#define LCD_E_GPIO_Port GPIOC
+#define LCD_RW_Pin GPIO_PIN_10
+#define LCD_RW_GPIO_Port GPIOC
+
+#endif
@@ -0,0 +1,24 @@
+#include "sleep_recorder.h"
+#include "hal_host.h"
+#include "sleep_ms.h"
+#include <string.h>
+
+SleepRecorderTypeDef sleep_recorder;
+
+static void sleep_recorder_hook(uint32_t ms) {
+  if (sleep_recorder.count < SLEEP_RECORDER_SIZE) {
+    sleep_recorder.ms[sleep_recorder.count] = ms;
+  }
+
+  sleep_recorder.count++;
+  sleep_recorder.total_ms += ms;
+  host_advance_ms(ms);
+}
+
+void sleep_recorder_install(void) {
+  memset(&sleep_recorder, 0, sizeof(sleep_recorder));
+  host_reset_busy_wait();
+  sleep_ms_set_hook(sleep_recorder_hook);
+}
+
+void sleep_recorder_remove(void) { sleep_ms_set_hook(NULL); }
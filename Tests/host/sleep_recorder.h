@@ -0,0 +1,21 @@
+#ifndef SLEEP_RECORDER_H
+#define SLEEP_RECORDER_H
+
+#include <stdint.h>
+
+/* sleep_ms hook stand-in. Records every requested duration and advances the
+ * virtual tick as if the core had slept until the wakeup */
+#define SLEEP_RECORDER_SIZE 256
+
+typedef struct {
+  uint32_t ms[SLEEP_RECORDER_SIZE];
+  uint32_t count;
+  uint32_t total_ms;
+} SleepRecorderTypeDef;
+
+extern SleepRecorderTypeDef sleep_recorder;
+
+void sleep_recorder_install(void);
+void sleep_recorder_remove(void);
+
+#endif
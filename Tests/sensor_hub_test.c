@@ -0,0 +1,180 @@
+#include "adc.h"
+#include "aht20.h"
+#include "aht20_model.h"
+#include "bmp280.h"
+#include "bmp280_model.h"
+#include "hal_host.h"
+#include "hw390.h"
+#include "sensor_hub.h"
+#include "sleep_recorder.h"
+#include <string.h>
+
+/* Cycle latency of the overlapped sensor hub against the blocking drivers
+ * called one after another, on a virtual tick stepped 1 ms per main loop */
+
+#define SOIL_ADC 2000
+
+ADC_HandleTypeDef hadc1;
+
+static I2C_HandleTypeDef hi2c;
+static HostAHT20TypeDef aht20_sensor;
+static HostBMP280TypeDef bmp280_sensor;
+
+static AHT20_HandleTypeDef haht20;
+static BMP280_HandleTypeDef hbmp280;
+static HW390_HandleTypeDef hhw390;
+static SensorHub_HandleTypeDef hhub;
+
+static void setup(void) {
+  memset(&hi2c, 0, sizeof(hi2c));
+  hi2c.State = HAL_I2C_STATE_READY;
+
+  host_i2c_detach_all();
+  host_aht20_init(&aht20_sensor, AHT20_ADDRESS);
+  host_bmp280_init(&bmp280_sensor, BMP280_ADDRESS_0);
+  host_i2c_attach(&aht20_sensor.i2c);
+  host_i2c_attach(&bmp280_sensor.i2c);
+  host_adc_value = SOIL_ADC;
+
+  sleep_recorder_install();
+
+  HOST_CHECK(AHT20_Init(&haht20, &hi2c, AHT20_ADDRESS) == HAL_OK);
+  HOST_CHECK(BMP280_Init(&hbmp280, &hi2c, BMP280_ADDRESS_0) == HAL_OK);
+  HOST_CHECK(BMP280_Configure(&hbmp280, BMP280_STANDBY_0_5MS,
+                              BMP280_FILTER_OFF, BMP280_OVERSAMPLING_2X,
+                              BMP280_OVERSAMPLING_16X,
+                              BMP280_MODE_SLEEP) == HAL_OK);
+  hw390_init(&hhw390, &hadc1, 1, 0);
+
+  sensor_hub_init(&hhub, &haht20, &hbmp280, &hhw390);
+}
+
+/* Main loop stand-in, returns the status that ended the cycle */
+static HAL_StatusTypeDef run_cycle(SensorHub_RecordTypeDef *record,
+                                   uint32_t *polls) {
+  HAL_StatusTypeDef status;
+
+  *polls = 0;
+  HOST_CHECK(sensor_hub_start(&hhub) == HAL_OK);
+
+  for (;;) {
+    status = sensor_hub_poll(&hhub, record);
+    (*polls)++;
+
+    if (status != HAL_BUSY || *polls > 10 * SENSOR_HUB_CYCLE_TIMEOUT) {
+      return status;
+    }
+
+    host_advance_ms(1);
+  }
+}
+
+/* Blocking reference, every driver waits for its own result */
+static uint32_t sequential_latency(void) {
+  uint32_t start = HAL_GetTick();
+  int32_t t, rh;
+  uint32_t p;
+
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+  HOST_CHECK(BMP280_MeasureForced(&hbmp280, &t, &p) == HAL_OK);
+  HOST_CHECK(hw390_read_average_data(&hhw390, SENSOR_HUB_SOIL_SAMPLES,
+                                     SENSOR_HUB_SOIL_INTERVAL) == SOIL_ADC);
+
+  return HAL_GetTick() - start;
+}
+
+static void test_cycle_latency(void) {
+  SensorHub_RecordTypeDef record;
+  uint32_t polls, sequential, soil_span;
+
+  setup();
+
+  HOST_CHECK(run_cycle(&record, &polls) == HAL_OK);
+  HOST_CHECK(record.valid == (SENSOR_HUB_VALID_AHT20 | SENSOR_HUB_VALID_BMP280 |
+                              SENSOR_HUB_VALID_HW390));
+  HOST_CHECK(record.aht20_temperature == 2500);
+  HOST_CHECK(record.aht20_humidity == 5000);
+  HOST_CHECK(record.bmp280_temperature == 2508);
+  HOST_CHECK(record.soil_adc == SOIL_ADC);
+
+  /* The soil averaging is the longest chain, the other sensors hide in it */
+  soil_span = (SENSOR_HUB_SOIL_SAMPLES - 1) * SENSOR_HUB_SOIL_INTERVAL;
+  HOST_CHECK(record.duration == soil_span);
+  HOST_CHECK(record.duration == HAL_GetTick() - record.tick);
+
+  sequential = sequential_latency();
+  HOST_CHECK(record.duration < sequential);
+
+  printf("Cycle latency: %u ms overlapped in %u polls, %u ms sequential\n",
+         (unsigned)record.duration, (unsigned)polls, (unsigned)sequential);
+}
+
+static void test_poll_idle(void) {
+  SensorHub_RecordTypeDef record;
+  uint32_t polls, duration;
+
+  setup();
+
+  // Nothing started yet
+  HOST_CHECK(sensor_hub_poll(&hhub, &record) == HAL_ERROR);
+
+  HOST_CHECK(run_cycle(&record, &polls) == HAL_OK);
+  duration = record.duration;
+
+  // The finished cycle is published once and its duration stays put
+  host_advance_ms(500);
+  memset(&record, 0, sizeof(record));
+  HOST_CHECK(sensor_hub_poll(&hhub, &record) == HAL_ERROR);
+  HOST_CHECK(record.valid == 0);
+  HOST_CHECK(hhub.record.duration == duration);
+
+  // And the next cycle can start
+  HOST_CHECK(run_cycle(&record, &polls) == HAL_OK);
+  HOST_CHECK(record.duration == duration);
+}
+
+static void test_start_while_running(void) {
+  setup();
+
+  HOST_CHECK(sensor_hub_start(&hhub) == HAL_OK);
+  HOST_CHECK(sensor_hub_start(&hhub) == HAL_BUSY);
+}
+
+static void test_timeout_aht20_stuck(void) {
+  SensorHub_RecordTypeDef record;
+  uint32_t polls;
+
+  setup();
+  aht20_sensor.stuck = 1;
+
+  // The AHT20 gives up on its own, the cycle ends with the soil average
+  HOST_CHECK(run_cycle(&record, &polls) == HAL_TIMEOUT);
+  HOST_CHECK(record.duration ==
+             (SENSOR_HUB_SOIL_SAMPLES - 1) * SENSOR_HUB_SOIL_INTERVAL);
+  HOST_CHECK(record.valid ==
+             (SENSOR_HUB_VALID_BMP280 | SENSOR_HUB_VALID_HW390));
+  HOST_CHECK(sensor_hub_poll(&hhub, &record) == HAL_ERROR);
+}
+
+static void test_timeout_bmp280_stuck(void) {
+  SensorHub_RecordTypeDef record;
+  uint32_t polls;
+
+  setup();
+  bmp280_sensor.stuck = 1;
+  hhub.timeout = 1500;
+
+  HOST_CHECK(run_cycle(&record, &polls) == HAL_TIMEOUT);
+  HOST_CHECK(record.duration == 1500);
+  HOST_CHECK(record.valid == (SENSOR_HUB_VALID_AHT20 | SENSOR_HUB_VALID_HW390));
+}
+
+int main(void) {
+  test_cycle_latency();
+  test_poll_idle();
+  test_start_while_running();
+  test_timeout_aht20_stuck();
+  test_timeout_bmp280_stuck();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,129 @@
+#include "adc.h"
+#include "aht20.h"
+#include "aht20_model.h"
+#include "bmp280.h"
+#include "bmp280_model.h"
+#include "hal_host.h"
+#include "hw390.h"
+#include "sleep_ms.h"
+#include "sleep_recorder.h"
+#include <string.h>
+
+/* Every driver wait must go through sleep_ms, so with a sleeping hook
+ * installed the core never busy-waits longer than 1 ms */
+
+#define MAX_BUSY_WAIT_MS 1
+
+ADC_HandleTypeDef hadc1;
+
+static I2C_HandleTypeDef hi2c;
+static HostAHT20TypeDef aht20_sensor;
+static HostBMP280TypeDef bmp280_sensor;
+
+static void setup(void) {
+  memset(&hi2c, 0, sizeof(hi2c));
+  hi2c.State = HAL_I2C_STATE_READY;
+
+  host_i2c_detach_all();
+  host_aht20_init(&aht20_sensor, AHT20_ADDRESS);
+  host_bmp280_init(&bmp280_sensor, BMP280_ADDRESS_0);
+  host_i2c_attach(&aht20_sensor.i2c);
+  host_i2c_attach(&bmp280_sensor.i2c);
+
+  sleep_recorder_install();
+}
+
+static bool recorded(uint32_t ms) {
+  for (uint32_t i = 0; i < sleep_recorder.count; i++) {
+    if (sleep_recorder.ms[i] == ms) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void test_aht20(void) {
+  AHT20_HandleTypeDef haht20;
+  int32_t t, rh;
+
+  setup();
+
+  HOST_CHECK(AHT20_Init(&haht20, &hi2c, AHT20_ADDRESS) == HAL_OK);
+  HOST_CHECK(AHT20_SoftReset(&haht20) == HAL_OK);
+  HOST_CHECK(AHT20_ReadAllFixed(&haht20, &t, &rh) == HAL_OK);
+
+  HOST_CHECK(recorded(AHT20_POWER_ON_DELAY));
+  HOST_CHECK(recorded(AHT20_INIT_DELAY));
+  HOST_CHECK(recorded(AHT20_SOFT_RESET_DELAY));
+  HOST_CHECK(recorded(AHT20_MEASURE_DELAY));
+  HOST_CHECK(host_busy_wait_max_ms <= MAX_BUSY_WAIT_MS);
+  HOST_CHECK(t == 2500);
+  HOST_CHECK(rh == 5000);
+
+  printf("AHT20: %u sleeps, %u ms slept, longest busy-wait %u ms\n",
+         (unsigned)sleep_recorder.count, (unsigned)sleep_recorder.total_ms,
+         (unsigned)host_busy_wait_max_ms);
+}
+
+static void test_bmp280(void) {
+  BMP280_HandleTypeDef hbmp280;
+  int32_t t;
+  uint32_t p;
+
+  setup();
+
+  HOST_CHECK(BMP280_Init(&hbmp280, &hi2c, BMP280_ADDRESS_0) == HAL_OK);
+  HOST_CHECK(BMP280_Configure(&hbmp280, BMP280_STANDBY_0_5MS,
+                              BMP280_FILTER_OFF, BMP280_OVERSAMPLING_2X,
+                              BMP280_OVERSAMPLING_16X,
+                              BMP280_MODE_SLEEP) == HAL_OK);
+  HOST_CHECK(BMP280_MeasureForced(&hbmp280, &t, &p) == HAL_OK);
+
+  HOST_CHECK(recorded((BMP280_GetMeasurementTime(&hbmp280) + 999) / 1000));
+  HOST_CHECK(host_busy_wait_max_ms <= MAX_BUSY_WAIT_MS);
+
+  printf("BMP280: %u sleeps, %u ms slept, longest busy-wait %u ms\n",
+         (unsigned)sleep_recorder.count, (unsigned)sleep_recorder.total_ms,
+         (unsigned)host_busy_wait_max_ms);
+}
+
+static void test_hw390(void) {
+  HW390_HandleTypeDef hhw390;
+
+  setup();
+  host_adc_value = 2000;
+
+  hw390_init(&hhw390, &hadc1, 1, 0);
+  HOST_CHECK(hw390_read_average_data(&hhw390, 10, 100) == 2000);
+
+  HOST_CHECK(sleep_recorder.count == 10);
+  HOST_CHECK(sleep_recorder.total_ms == 1000);
+  HOST_CHECK(host_busy_wait_max_ms <= MAX_BUSY_WAIT_MS);
+
+  printf("HW390: %u sleeps, %u ms slept, longest busy-wait %u ms\n",
+         (unsigned)sleep_recorder.count, (unsigned)sleep_recorder.total_ms,
+         (unsigned)host_busy_wait_max_ms);
+}
+
+/* Without a hook the default HAL_Delay spins, which the check must catch */
+static void test_default_hook_busy_waits(void) {
+  AHT20_HandleTypeDef haht20;
+
+  setup();
+  sleep_recorder_remove();
+
+  HOST_CHECK(AHT20_Init(&haht20, &hi2c, AHT20_ADDRESS) == HAL_OK);
+
+  HOST_CHECK(sleep_recorder.count == 0);
+  HOST_CHECK(host_busy_wait_max_ms == AHT20_POWER_ON_DELAY);
+}
+
+int main(void) {
+  test_aht20();
+  test_bmp280();
+  test_hw390();
+  test_default_hook_busy_waits();
+
+  return HOST_RESULT();
+}
@@ -0,0 +1,42 @@
+#include "sleep_ms.h"
+#include "stm32l4xx_hal.h"
+
+static sleep_ms_hook_t sleep_hook = HAL_Delay;
+
+/**
+ * @brief Wait for given number of milliseconds using the registered hook
+ * @param ms Milliseconds to wait
+ * @note Used by the drivers for all fixed waits (conversion times, power-on
+ * and reset delays), so the application decides how the core spends them
+ */
+void sleep_ms(uint32_t ms) { sleep_hook(ms); }
+
+/**
+ * @brief Register wait hook used by sleep_ms
+ * @param hook Function waiting at least given number of milliseconds, e.g.
+ * sleep_ms_wfi or an application hook entering Stop 2 until an LPTIM/RTC
+ * wakeup. NULL restores the default HAL_Delay busy-wait
+ */
+void sleep_ms_set_hook(sleep_ms_hook_t hook) {
+  sleep_hook = (hook != NULL) ? hook : HAL_Delay;
+}
+
+/**
+ * @brief Wait in Sleep mode, the core is halted between SysTick interrupts
+ * @param ms Milliseconds to wait (same minimum wait guarantee as HAL_Delay)
+ * @note Any other enabled interrupt also wakes the core, the remaining time is
+ * slept again
+ */
+void sleep_ms_wfi(uint32_t ms) {
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t wait = ms;
+
+  // Add a frequency to guarantee minimum wait
+  if (wait < HAL_MAX_DELAY) {
+    wait += (uint32_t)HAL_GetTickFreq();
+  }
+
+  while ((HAL_GetTick() - tickstart) < wait) {
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+  }
+}
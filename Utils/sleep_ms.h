@@ -0,0 +1,12 @@
+#ifndef SLEEP_MS_H
+#define SLEEP_MS_H
+
+#include <stdint.h>
+
+typedef void (*sleep_ms_hook_t)(uint32_t ms);
+
+void sleep_ms(uint32_t ms);
+void sleep_ms_set_hook(sleep_ms_hook_t hook);
+void sleep_ms_wfi(uint32_t ms);
+
+#endif